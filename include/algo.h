@@ -3,10 +3,25 @@
 #define MINISTL_ALGO_H
 
 #include <string.h>
+#include "iterator.h"
 #include "type_traits.h"
+#include "util.h"       // for move
+#include <type_traits>  // for is_pointer, remove_cv
 
 namespace ministl {
 
+// max 和 min 函数
+
+template <typename T>
+inline const T& max(const T& a, const T& b) {
+    return a < b ? b : a;
+}
+
+template <typename T>
+inline const T& min(const T& a, const T& b) {
+    return b < a ? b : a;
+}
+
 // copy 函数
 
 template <typename InputIterator, typename OutputIterator, typename Distance>
@@ -35,7 +50,8 @@ inline OutputIterator _copy(RandomAccessIterator first,
 
 template <typename T>
 inline T* _copy_trivial(const T* first, const T* last, T* result) {
-    memmove(result, first, sizeof(T) * (first - last));
+    if (first != last)
+        memmove(result, first, sizeof(T) * (last - first));
     return result + (last - first);
 }
 
@@ -44,7 +60,7 @@ inline OutputIterator _copy_aux2(InputIterator first, InputIterator last,
                                 OutputIterator result, ministl::false_type) {
     return _copy(first, last, result, 
                  iterator_category(first), 
-                 difference_type(first))
+                 difference_type(first));
 }
 
 template <typename InputIterator, typename OutputIterator>
@@ -52,7 +68,7 @@ inline OutputIterator _copy_aux2(InputIterator first, InputIterator last,
                                 OutputIterator result, ministl::true_type) {
     return _copy(first, last, result, 
                  iterator_category(first), 
-                 difference_type(first))
+                 difference_type(first));
 }
 
 template <typename T>
@@ -60,6 +76,11 @@ inline T* _copy_aux2(const T* first, const T* last, T* result, ministl::true_typ
     return _copy_trivial(first, last, result);
 }
 
+template <typename T>
+inline T* _copy_aux2(T* first, T* last, T* result, ministl::true_type) {
+    return _copy_trivial((const T*) first, (const T*) last, result);
+}
+
 template <typename InputIterator, typename OutputIterator, typename T>
 inline OutputIterator _copy_aux(InputIterator first, InputIterator last,
                                 OutputIterator result, T*) {
@@ -67,7 +88,7 @@ inline OutputIterator _copy_aux(InputIterator first, InputIterator last,
     return _copy_aux2(first, last, result, Trivial());
 }
 
-template <typename InputIterator, typename OutputIterator, typename T>
+template <typename InputIterator, typename OutputIterator>
 inline OutputIterator copy(InputIterator first, InputIterator last, 
                            OutputIterator result) {
     return _copy_aux(first, last, result, value_type(first));
@@ -114,6 +135,58 @@ inline BidirectionalIterator2 copy_backward(BidirectionalIterator1 first,
                           difference_type(first));
 }
 
+// move 和 move_backward 函数
+// 与 copy 相同，但使用移动赋值，trivial assignment 的型别直接调用 copy
+
+template <typename InputIterator, typename OutputIterator>
+inline OutputIterator _move_aux(InputIterator first, InputIterator last,
+                                OutputIterator result, ministl::true_type) {
+    return ministl::copy(first, last, result);
+}
+
+template <typename InputIterator, typename OutputIterator>
+inline OutputIterator _move_aux(InputIterator first, InputIterator last,
+                                OutputIterator result, ministl::false_type) {
+    for ( ; first != last; ++result, ++first)
+        *result = ministl::move(*first);
+    return result;
+}
+
+template <typename InputIterator, typename OutputIterator>
+inline OutputIterator move(InputIterator first, InputIterator last,
+                           OutputIterator result) {
+    typedef typename iterator_traits<InputIterator>::value_type T;
+    typedef typename type_traits<T>::has_trivial_assignment_operator Trivial;
+    return _move_aux(first, last, result, Trivial());
+}
+
+template <typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 _move_backward_aux(BidirectionalIterator1 first,
+                                                 BidirectionalIterator1 last,
+                                                 BidirectionalIterator2 result,
+                                                 ministl::true_type) {
+    return ministl::copy_backward(first, last, result);
+}
+
+template <typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 _move_backward_aux(BidirectionalIterator1 first,
+                                                 BidirectionalIterator1 last,
+                                                 BidirectionalIterator2 result,
+                                                 ministl::false_type) {
+    while (first != last)
+        *--result = ministl::move(*--last);
+    return result;
+}
+
+template <typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 move_backward(BidirectionalIterator1 first,
+                                            BidirectionalIterator1 last,
+                                            BidirectionalIterator2 result) {
+    typedef typename iterator_traits<BidirectionalIterator1>::value_type T;
+    typedef typename type_traits<T>::has_trivial_assignment_operator Trivial;
+    return _move_backward_aux(first, last, result, Trivial());
+}
+
 // fill 和 fill_n 函数
 
 template <typename ForwardIterator, typename T>
@@ -144,7 +217,7 @@ inline void fill(signed char* first, signed char* last,
 }
 
 inline void fill(char* first, char* last, const char& value) {
-    char temp;
+    char temp = value;
     memset(first, temp, last - first);
 }
 
@@ -163,11 +236,110 @@ inline signed char* fill_n(signed char* first, Size n,
 }
 
 template <typename Size>
-inline char* fill_n(char* first, Size n, const char* value) {
+inline char* fill_n(char* first, Size n, const char& value) {
     fill(first, first + n, value);
     return first + n;
 } 
 
+// equal 和 lexicographical_compare 函数
+
+// 两个迭代器都是指向同一种 trivially comparable 类型的指针时可以按字节比较
+template <typename InputIterator1, typename InputIterator2>
+struct _memcmp_comparable {
+    typedef typename std::remove_pointer<InputIterator1>::type P1;
+    typedef typename std::remove_pointer<InputIterator2>::type P2;
+    typedef typename std::remove_cv<P1>::type T1;
+    typedef typename std::remove_cv<P2>::type T2;
+    typedef typename bool_type<std::is_pointer<InputIterator1>::value
+                               && std::is_pointer<InputIterator2>::value
+                               && std::is_same<T1, T2>::value
+                               && is_trivially_comparable<T1>::value>::type type;
+};
+
+template <typename InputIterator1, typename InputIterator2>
+inline bool _equal_aux(InputIterator1 first1, InputIterator1 last1,
+                       InputIterator2 first2, ministl::false_type) {
+    for ( ; first1 != last1; ++first1, ++first2)
+        if (!(*first1 == *first2))
+            return false;
+    return true;
+}
+
+// memcmp 由 libc 用 SIMD 实现，大数组的比较可以达到内存带宽
+template <typename InputIterator1, typename InputIterator2>
+inline bool _equal_aux(InputIterator1 first1, InputIterator1 last1,
+                       InputIterator2 first2, ministl::true_type) {
+    return first1 == last1
+        || 0 == memcmp(first1, first2, (last1 - first1) * sizeof(*first1));
+}
+
+// [first1, last1) 与从 first2 开始的同样个数的元素是否相等
+template <typename InputIterator1, typename InputIterator2>
+inline bool equal(InputIterator1 first1, InputIterator1 last1,
+                  InputIterator2 first2) {
+    typedef typename _memcmp_comparable<InputIterator1, InputIterator2>::type trivial;
+    return _equal_aux(first1, last1, first2, trivial());
+}
+
+/**
+ * 返回 [a, a+n) 和 [b, b+n) 第一个不同元素的下标，全部相同时返回 n
+ * 先按块用 memcmp 跳过相同的部分，再在不同的块中逐个比较
+ */
+template <typename T>
+inline size_t _mismatch_trivial(const T* a, const T* b, size_t n) {
+    const size_t BLOCK = 256 / sizeof(T) ? 256 / sizeof(T) : 1;
+    size_t i = 0;
+    while (n - i >= BLOCK && 0 == memcmp(a + i, b + i, BLOCK * sizeof(T)))
+        i += BLOCK;
+    while (i < n && a[i] == b[i])
+        ++i;
+    return i;
+}
+
+template <typename InputIterator1, typename InputIterator2>
+inline bool _lexicographical_compare_aux(InputIterator1 first1, InputIterator1 last1,
+                                         InputIterator2 first2, InputIterator2 last2,
+                                         ministl::false_type) {
+    for ( ; first1 != last1 && first2 != last2; ++first1, ++first2) {
+        if (*first1 < *first2)
+            return true;
+        if (*first2 < *first1)
+            return false;
+    }
+    return first1 == last1 && first2 != last2;
+}
+
+template <typename InputIterator1, typename InputIterator2>
+inline bool _lexicographical_compare_aux(InputIterator1 first1, InputIterator1 last1,
+                                         InputIterator2 first2, InputIterator2 last2,
+                                         ministl::true_type) {
+    const size_t len1 = last1 - first1;
+    const size_t len2 = last2 - first2;
+    const size_t n = len1 < len2 ? len1 : len2;
+    const size_t i = _mismatch_trivial(&*first1, &*first2, n);
+    if (i < n)
+        return first1[i] < first2[i];
+    return len1 < len2;
+}
+
+// 字典序比较 [first1, last1) 和 [first2, last2)
+template <typename InputIterator1, typename InputIterator2>
+inline bool lexicographical_compare(InputIterator1 first1, InputIterator1 last1,
+                                    InputIterator2 first2, InputIterator2 last2) {
+    typedef typename _memcmp_comparable<InputIterator1, InputIterator2>::type trivial;
+    return _lexicographical_compare_aux(first1, last1, first2, last2, trivial());
+}
+
+// 对于 unsigned char，memcmp 的结果就是字典序
+inline bool lexicographical_compare(const unsigned char* first1, const unsigned char* last1,
+                                    const unsigned char* first2, const unsigned char* last2) {
+    const size_t len1 = last1 - first1;
+    const size_t len2 = last2 - first2;
+    const size_t n = len1 < len2 ? len1 : len2;
+    const int result = n ? memcmp(first1, first2, n) : 0;
+    return result != 0 ? result < 0 : len1 < len2;
+}
+
 
 
 
@@ -5,7 +5,15 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>    // for sort
 #include "util.h"
+#include "size_class.h"
+#include "chunk_source.h"
 
 #ifndef MINISTL_THROW_BAD_ALLOC
 #include <new>
@@ -16,19 +24,21 @@ namespace ministl {
     
 /**
  * 一级内存配置器
- * 使用 malloc 直接分配内存
+ * 直接从 ChunkSource 分配内存，默认的 malloc_chunk_source 即使用 malloc
  * 在 SGI_STL 中还添加了模板 template <int inst>
  * 但是这个模板参数并没有用到
  * 而参数名 inst 似乎也只是意味着生成一个实例
  * 在 SGI_STL 的注释中提到：仅用于允许创建多个实例
- * 以下实现中没有加上这个模板
+ * 这里的模板参数是内存来源，见 chunk_source.h
+ * 每种内存来源各有一个 oom_handler
  */
+template <typename ChunkSource>
 class first_alloc_template {
 
 private:
     // oom: out of memory
     static void * oom_malloc(size_t);
-    static void * oom_realloc(void *, size_t);
+    static void * oom_realloc(void *, size_t, size_t);
     // 用于处理 oom 时的函数指针
     // 参考了 SGI_STL 中实现
     static void (* oom_handler) ();
@@ -36,24 +46,46 @@ private:
 public:
     static void * allocate(size_t n) {
         _MINISTL_DEBUG("first_alloc allocate size %d\n", n);
-        void *result = malloc(n);
-        // 如果 malloc 失败了，则会调用 oom_malloc
+        void *result = ChunkSource::allocate(n);
+        // 如果分配失败了，则会调用 oom_malloc
         if (0 == result) result = oom_malloc(n);
         return result;
     }
 
-    static void * reallocate(void *p, size_t n) {
-        _MINISTL_DEBUG("first_alloc reallocate at %p to size %d\n", p, n);
-        void *result = realloc(p, n);
-        if (0 == result) result = oom_realloc(p, n);
+    static void * reallocate(void *p, size_t old_size, size_t new_size) {
+        _MINISTL_DEBUG("first_alloc reallocate at %p to size %d\n", p, new_size);
+        void *result = ChunkSource::reallocate(p, old_size, new_size);
+        if (0 == result) result = oom_realloc(p, old_size, new_size);
         return result;
     }
 
-    static void deallocate(void *p, size_t) {
+    static void deallocate(void *p, size_t n) {
         _MINISTL_DEBUG("first_alloc deallocate at %p\n", p);
-        free(p); 
+        ChunkSource::deallocate(p, n);
+    }
+
+    /**
+     * 分配按 align 对齐的内存，align 为 2 的幂
+     * align 不超过 ChunkSource::ALIGNMENT 时与 allocate 相同
+     * 否则多申请 align 字节，对齐后的地址之前保存原始地址
+     * 必须用相同的 n 和 align 调用 deallocate_aligned 归还
+     */
+    static void * allocate_aligned(size_t n, size_t align) {
+        if (align <= ChunkSource::ALIGNMENT) return allocate(n);
+        char *raw = (char *) allocate(n + align);
+        char *result = (char *) _align_up((size_t) raw + sizeof(void *), align);
+        ((void **) result)[-1] = raw;
+        return result;
+    }
+
+    static void deallocate_aligned(void *p, size_t n, size_t align) {
+        if (align <= ChunkSource::ALIGNMENT) deallocate(p, n);
+        else deallocate(((void **) p)[-1], n + align);
     }
 
+    // 申请 n 个字节时实际可用的字节数
+    static size_t good_size(size_t n) { return n; }
+
     static void (* set_malloc_handler(void (*f)() )) () {
         void (* old) () = oom_handler;
         oom_handler = f;
@@ -62,9 +94,11 @@ public:
 
 };
 
-void (* first_alloc_template::oom_handler)() = 0;
+template <typename ChunkSource>
+void (* first_alloc_template<ChunkSource>::oom_handler)() = 0;
 
-void * first_alloc_template::oom_malloc(size_t n) {
+template <typename ChunkSource>
+void * first_alloc_template<ChunkSource>::oom_malloc(size_t n) {
     void (* my_malloc_handler)();
     void * result;
 
@@ -72,12 +106,13 @@ void * first_alloc_template::oom_malloc(size_t n) {
         my_malloc_handler = oom_handler;
         if (nullptr == my_malloc_handler) { MINISTL_THROW_BAD_ALLOC; }
         (* my_malloc_handler)();    // 调用处理函数
-        result = malloc(n);         // 再次尝试申请内存
+        result = ChunkSource::allocate(n);  // 再次尝试申请内存
         if (result) return result;
     }
 }
 
-void * first_alloc_template::oom_realloc(void *p, size_t n) {
+template <typename ChunkSource>
+void * first_alloc_template<ChunkSource>::oom_realloc(void *p, size_t old_size, size_t new_size) {
     void (*my_malloc_handler)();
     void *result;
 
@@ -85,54 +120,321 @@ void * first_alloc_template::oom_realloc(void *p, size_t n) {
         my_malloc_handler = oom_handler;
         if (nullptr == my_malloc_handler) { MINISTL_THROW_BAD_ALLOC; }
         (* my_malloc_handler)();
-        result = realloc(p, n);
+        result = ChunkSource::reallocate(p, old_size, new_size);
         if (result) return result;
     }
 }
 
+typedef first_alloc_template<malloc_chunk_source> malloc_alloc;
+
 /**
- * 二级内存配置器，也是默认配置器
+ * 二级内存配置器，default_alloc_template 是它的默认配置
  * 对于分配小区块内存提高性能
- * 当分配内存大于128字节时使用一级内存配置器，小于等于128字节使用二级
+ * 当分配内存大于 MAX_BYTES 时使用一级内存配置器，小于等于 MAX_BYTES 使用二级
  * 会先分配一大块内存
- * 用一个长度为 16 的链表维护小内存的分配和回收
+ * 用 NFREELISTS 个链表维护小内存的分配和回收
  * 链表的每个节点是一个固定内存大小区块的链表
+ * 区块大小的划分由模板参数 SizeClass 决定，见 size_class.h
+ * default_alloc_template 使用 linear_size_class<8, 128>，即
  * 8 16 24 32 40 48 56 64 72 80 88 96 104 112 120 128
- * 目前只有单线程，没有考虑多线程操作
+ * geometric_alloc_template 使用 geometric_size_class<4096>，4096 字节以内都由内存池分配
+ * 不同的模板实例拥有各自独立的内存池
+ *
+ * 内存来源：
+ * 模板参数 ChunkSource 决定 chunk_alloc 和一级配置器的内存从哪里来，见 chunk_source.h
+ * 例如 pool_alloc_template<linear_size_class<>, mmap_chunk_source> 的 chunk 都是 2MB 对齐的大页
+ * 注意大于 MAX_BYTES 的请求不经过内存池，每次都直接调用 ChunkSource::allocate / deallocate，
+ * 对 mmap_chunk_source 来说每个大区块是一次 mmap 和一次 munmap 系统调用 (至少一页)
+ * 大于 MAX_BYTES 的分配频繁时，选择 MAX_BYTES 更大的 SizeClass (例如 geometric_size_class<65536>)，
+ * 让它们也由内存池批量分配
+ *
+ * 多线程：
+ * 每个线程有一份自己的 free list (线程缓存)，allocate 和 deallocate 只操作
+ * 本线程的链表，不需要加锁
+ * 所有线程共享一个中心内存池 (free_list, start_free, end_free, heap_size)，由 pool_lock 保护
+ * 线程缓存为空时，加锁从中心内存池批量取出 batch 个区块
+ * 线程缓存中某个链表超过 2 * batch 个区块时，加锁归还多出 batch 的部分
+ * 线程退出时，线程缓存中的区块全部归还中心内存池
+ *
+ * 批量大小：
+ * 每个线程的每个 size class 各有一个 batch，从 refill_min_objs 开始
+ * 每次 refill 说明这个 size class 的需求还没有被满足，batch 翻倍
+ * 链表过长需要归还时说明释放多于分配，batch 减半
+ * batch 不超过 refill_max_objs 个区块，也不超过 refill_max_bytes 字节
+ * 三个上下界可以通过 set_refill_bounds() 设置
+ *
+ * 统计：
+ * 分配、回收次数记录在线程缓存中，只由所属线程写入，不需要加锁也不需要原子的读改写
+ * refill、chunk_alloc 等慢路径的计数记录在中心内存池中，由 pool_lock 保护
+ * get_stats() 汇总以上计数，返回一份 alloc_stats 快照
+ *
+ * 归还内存：
+ * chunk_alloc 向 heap 申请的每一块内存 (chunk) 头部都有一个 chunk_header，串成 chunks 链表
+ * trim() 把中心内存池中空闲的区块按地址排序，逐个 chunk 统计空闲的字节数
+ * 整个 chunk 都空闲时，将这个 chunk 归还给 heap
+ * 否则把地址连续的空闲区块合并，其中完整的页使用 ChunkSource::purge (即 madvise) 交还给操作系统，
+ * 合并后的区域记录在 spans 中，chunk_alloc 在向 heap 申请内存之前会优先使用这些区域
+ * 其他线程缓存中的区块被看作正在使用，调用 trim() 的线程会先归还自己的缓存
+ * background_trimmer 可以在后台线程中定期调用 trim()
+ *
+ * 对齐：
+ * 内存池按每个 size class 的自然对齐 (区块大小最低的 1 位，不超过页大小) 切分区块
+ * 例如 64 字节的区块按 64 字节对齐，4096 字节的区块按页对齐
+ * allocate_aligned 选择区块大小是 align 倍数的 size class，不需要额外的空间和额外的查找
+ * align 超过页大小或没有这样的 size class 时交给一级配置器的 allocate_aligned
  */
-class default_alloc_template {
+template <typename SizeClass, typename ChunkSource = malloc_chunk_source>
+class pool_alloc_template {
 
 private:
-    static const int ALIGN = 8;
-    static const int MAX_BYTES = 128;
-    static const int NFREELISTS = 16;
+    static const size_t ALIGN = SizeClass::ALIGN;
+    static const size_t MAX_BYTES = SizeClass::MAX_BYTES;
+    static const size_t NFREELISTS = SizeClass::NFREELISTS;
+
+    // 大于 MAX_BYTES 的请求交给使用同一个内存来源的一级配置器
+    typedef first_alloc_template<ChunkSource> large_alloc;
 
-    // 将bytes上调至8的倍数
+    // 将bytes上调至 ALIGN 的倍数
     static size_t ROUND_UP(size_t bytes) {
         // ((n + 7) & (~7))
         return ((bytes) + ALIGN-1) & ~(ALIGN-1);
     }
 
+public:
+    /**
+     * 统计信息快照
+     * 每个 free list 对应一个 class_stats
+     * free_objs 包括中心内存池和所有线程缓存中空闲的区块
+     */
+    struct class_stats {
+        size_t bytes;           // 区块大小
+        size_t allocations;     // allocate 次数
+        size_t frees;           // deallocate 次数
+        size_t refills;         // refill 次数
+        size_t refilled_objs;   // refill 取得的区块总数，refilled_objs / refills 为平均批量
+        size_t releases;        // 线程缓存过长而归还中心内存池的次数
+        size_t chunk_allocs;    // 因为这个大小的请求而向 heap 申请内存的次数
+        size_t free_objs;       // 空闲在 free list 中的区块个数
+    };
+
+    struct alloc_stats {
+        class_stats classes[NFREELISTS];
+        size_t heap_size;           // 向 heap 申请且还未归还的字节数
+        size_t chunks;              // 向 heap 申请且还未归还的 chunk 个数
+        size_t free_list_bytes;     // 空闲在 free list 中的字节数
+        size_t pool_bytes;          // 内存池中剩余还未切分的字节数 (end_free - start_free)
+        size_t span_bytes;          // trim() 合并出来等待复用的字节数
+        size_t trimmed_bytes;       // trim() 累计归还给 heap 或操作系统的字节数
+        size_t large_allocations;   // 大于 MAX_BYTES 转交一级配置器的 allocate 次数
+        size_t large_frees;         // 大于 MAX_BYTES 转交一级配置器的 deallocate 次数
+        size_t large_bytes;         // 一级配置器中还未归还的字节数
+    };
+
+    static alloc_stats get_stats();
+
+    /**
+     * 将空闲的内存归还给 heap 和操作系统
+     * 返回本次归还的字节数，包括释放的 chunk 和 madvise 的页
+     */
+    static size_t trim();
+
+    /**
+     * 设置 refill 批量大小的上下界
+     * 每次 refill 至少 min_objs 个区块，至多 max_objs 个区块且不超过 max_bytes 字节
+     * 已经在运行的线程会在之后的 refill 和 release 中逐渐调整到新的范围内
+     */
+    static void set_refill_bounds(int min_objs, int max_objs, size_t max_bytes) {
+        if (min_objs < 1) min_objs = 1;
+        if (max_objs < min_objs) max_objs = min_objs;
+        refill_min_objs.store(min_objs, std::memory_order_relaxed);
+        refill_max_objs.store(max_objs, std::memory_order_relaxed);
+        refill_max_bytes.store(max_bytes, std::memory_order_relaxed);
+    }
+
+private:
     union obj {                 // free_lists的节点构造
         union obj * free_list_link;
         char client_data[1];    // The client sees this
     };
 
-    // 16 个 free_lists,
-    static obj * volatile free_list[NFREELISTS];
+    /**
+     * 只由所属线程写入，其他线程在 get_stats() 中读取的计数器
+     * 写入使用 relaxed 的 load + store 而不是 fetch_add，开销和普通变量一样
+     */
+    struct stat_counter {
+        std::atomic<size_t> value;
+        size_t get() const { return value.load(std::memory_order_relaxed); }
+        void add(size_t n) {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+        void sub(size_t n) {
+            value.store(value.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * 线程缓存
+     * 只有 trivial 的构造和析构，线程第一次使用时全部为 0，访问时不需要额外的初始化检查
+     * registered 表示已经加入 caches 链表，线程退出时会被归还
+     * retired 表示线程已经退出，缓存中的区块已经归还，limit 全部为 0
+     * 之后 (例如在其他 thread_local 对象的析构函数中) 的分配和释放直接经过中心内存池，见 flush_retired
+     * batch 为 0 表示还没有 refill 过，limit 为链表的最大长度 2 * batch
+     */
+    struct thread_cache {
+        obj * free_list[NFREELISTS];
+        stat_counter length[NFREELISTS];
+        int batch[NFREELISTS];
+        size_t limit[NFREELISTS];
+        stat_counter allocations[NFREELISTS];
+        stat_counter frees[NFREELISTS];
+        stat_counter large_allocations;
+        stat_counter large_frees;
+        stat_counter large_bytes;
+        thread_cache * prev;        // 所有已注册线程缓存组成的双向链表，由 pool_lock 保护
+        thread_cache * next;
+        bool registered;
+        bool retired;
+    };
+
+    // 线程退出时负责把 tcache 归还给中心内存池，在 attach_cache 中第一次使用时构造
+    struct thread_cache_reaper {
+        thread_cache_reaper() { }
+        ~thread_cache_reaper();
+    };
+
+    static thread_local thread_cache tcache;
+    static thread_local thread_cache_reaper reaper;
+
+    // 保护中心内存池
+    static std::mutex pool_lock;
+
+    // 中心内存池的 free_lists，由 pool_lock 保护
+    static obj * free_list[NFREELISTS];
+    static size_t free_list_length[NFREELISTS];
+
+    // 已注册的线程缓存链表
+    static thread_cache * caches;
+
+    // 中心内存池的计数，以及已退出线程留下的计数，由 pool_lock 保护
+    static size_t refills[NFREELISTS];
+    static size_t refilled_objs[NFREELISTS];
+    static size_t releases[NFREELISTS];
+    static size_t chunk_allocs[NFREELISTS];
+    static size_t retired_allocations[NFREELISTS];
+    static size_t retired_frees[NFREELISTS];
+    static size_t retired_large_allocations;
+    static size_t retired_large_frees;
+    static size_t retired_large_bytes;
+
+    // 将本线程的缓存加入 caches 链表，并确保线程退出时归还缓存
+    static void attach_cache();
+
+    // 将本线程缓存中的区块全部归还中心内存池，调用者持有 pool_lock
+    static void flush_cache();
+
+    // 将本线程的计数累加到 retired_* 中并清零，调用者持有 pool_lock
+    static void retire_counters();
+
+    // 线程退出之后，缓存中的区块归还中心内存池，计数累加到 retired_* 中
+    // 不在 caches 链表中的缓存 get_stats() 看不到，也不会再被 flush
+    static void flush_retired();
+
+    // 每个 chunk 头部的信息，chunk 的可用空间紧跟在 CHUNK_HEADER 个字节之后
+    struct chunk_header {
+        chunk_header * next;
+        size_t bytes;           // 可用空间的字节数
+    };
+
+    // trim() 合并出来的一段连续空闲区域
+    struct span {
+        char * start;
+        size_t bytes;
+    };
+
+    // trim() 中收集的一项空闲区域，index 为 size class 下标，SPAN 表示 span 或内存池的剩余空间
+    struct free_range {
+        char * start;
+        size_t bytes;
+        size_t index;
+        bool purged;            // 之前的 trim() 已经 madvise 过
+    };
+
+    static const size_t CHUNK_HEADER = (sizeof(chunk_header) + ALIGN - 1) & ~(ALIGN - 1);
+    static const size_t SPAN = (size_t) -1;
+    static const size_t DROPPED = (size_t) -2;
+
+    // 以下由 pool_lock 保护
+    static chunk_header * chunks;
+    static size_t nchunks;
+    static span * spans;
+    static size_t nspans;
+    static size_t spans_capacity;
+    static size_t trimmed_bytes;
+
+    // 从 ChunkSource 申请一个可用空间至少为 bytes 的 chunk，返回可用空间的起始位置
+    // chunk 的大小会上调至 ChunkSource::GRANULARITY 的倍数，bytes 被修改为实际的可用空间
+    static char * new_chunk(size_t & bytes, bool use_first_alloc);
+
+    // 合并 [first, last) 中地址连续的空闲区域，并 purge 其中完整的页
+    static size_t purge(free_range * first, free_range * last);
 
     static size_t FREELIST_INDEX(size_t bytes) {
         // bytes应该是大于 0 的
-        // ((bytes + 7)/8) - 1 的结果是从 0 开始的
-        return (((bytes) + ALIGN-1)/ALIGN - 1);
+        return SizeClass::index(bytes);
+    }
+
+    // 第 index 个 free list 的区块大小
+    static size_t CLASS_SIZE(size_t index) {
+        return SizeClass::size(index);
+    }
+
+    /**
+     * 大小为 size 的区块的自然对齐，即 size 最低的 1 位，不超过页大小
+     * 内存池切分区块时按自然对齐，所以 free list 中的每个区块都满足自己的自然对齐
+     */
+    static size_t CLASS_ALIGN(size_t size) {
+        size_t align = size & (0 - size);
+        return align < _page_size() ? align : _page_size();
+    }
+
+    // 能满足 n 字节、按 align 对齐的请求的 size class 下标，没有时返回 NFREELISTS
+    static size_t ALIGNED_INDEX(size_t n, size_t align) {
+        if (align > _page_size()) return NFREELISTS;
+        n = _align_up(n, align);
+        if (n > MAX_BYTES) return NFREELISTS;
+        size_t index = FREELIST_INDEX(n);
+        while (index < NFREELISTS && CLASS_SIZE(index) % align != 0) ++index;
+        return index;
     }
 
-    static void *refill(size_t n);
+    // refill 批量大小的上下界
+    static std::atomic<int> refill_min_objs;
+    static std::atomic<int> refill_max_objs;
+    static std::atomic<size_t> refill_max_bytes;
+
+    // 第 index 个 size class 允许的最大批量
+    static int max_batch(size_t index) {
+        int min_objs = refill_min_objs.load(std::memory_order_relaxed);
+        int max_objs = refill_max_objs.load(std::memory_order_relaxed);
+        size_t by_bytes = refill_max_bytes.load(std::memory_order_relaxed) / CLASS_SIZE(index);
+        if (by_bytes < (size_t) max_objs) max_objs = (int) by_bytes;
+        return max_objs < min_objs ? min_objs : max_objs;
+    }
+
+    static void *refill(size_t index);
+
+    // 线程缓存中第 index 个链表超过 limit，缩小 batch 并将多余的区块归还中心内存池
+    static void release(size_t index);
 
     // 配置一大块空间，可容纳 nobjs 个 size 大小的区块
     // 如果无法分配 nobjs 个区块， nobjs 可能会降低，nobjs 是传递引用
+    // 返回的地址按 CLASS_ALIGN(size) 对齐
+    // 调用者需要持有 pool_lock
     static char *chunk_alloc(size_t size, int &nobjs);
 
+    // 将 [start_free, last) 切成满足自然对齐的区块编入 free list，调用者持有 pool_lock
+    static void stash_leftover(char * last);
+
     static char *start_free;    // 内存池的起始位置，只在chunk_alloc()中变化
     static char *end_free;      // 内存池的结束位置，只在chunk_alloc()中变化
     static size_t heap_size;
@@ -140,98 +442,414 @@ private:
 public:
     // n must be > 0
     static void * allocate(size_t n) {
-        obj * volatile * my_free_list;
+        obj ** my_free_list;
         obj * result;
-        // 如果 n 大于 128 则使用一级配置器
-        if (n > MAX_BYTES) return first_alloc_template::allocate(n);
+        // 如果 n 大于 MAX_BYTES 则使用一级配置器
+        if (n > MAX_BYTES) {
+            if (!tcache.registered) attach_cache();
+            void *r = large_alloc::allocate(n);
+            tcache.large_allocations.add(1);
+            tcache.large_bytes.add(n);
+            if (tcache.retired) flush_retired();
+            return r;
+        }
         _MINISTL_DEBUG("default_alloc allocate size %d\n", n);
-        // 寻找16个free lists中适当的一个
-        my_free_list = free_list + FREELIST_INDEX(n);
+        // 寻找本线程free lists中适当的一个
+        size_t index = FREELIST_INDEX(n);
+        tcache.allocations[index].add(1);
+        my_free_list = tcache.free_list + index;
         result = *my_free_list;
         if (nullptr == result) {
-            // 没有可用的 free list，准备重新填充 free list
-            void *r = refill(ROUND_UP(n));
+            // 线程缓存为空，准备从中心内存池批量填充
+            void *r = refill(index);
             return r;
         }
         // 调整 free list
         *my_free_list = result->free_list_link;
+        tcache.length[index].sub(1);
         _MINISTL_DEBUG("default_alloc allocate successful\n");
         return result;
     }
 
     // p 不是 nullptr
     static void deallocate(void *p, size_t n) {
-        // 如果 n 大于 128 则使用一级配置器
+        // 如果 n 大于 MAX_BYTES 则使用一级配置器
         if (n > MAX_BYTES) {
-            first_alloc_template::deallocate(p, n);
+            if (!tcache.registered) attach_cache();
+            large_alloc::deallocate(p, n);
+            tcache.large_frees.add(1);
+            tcache.large_bytes.sub(n);
+            if (tcache.retired) flush_retired();
             return;
         }
         _MINISTL_DEBUG("default_alloc deallocate at %p size %d\n", p, n);
         // 这里将 p 转为 obj* 给 q。
         obj * q = (obj*) p;
-        obj * volatile * my_free_list;
+        obj ** my_free_list;
         // 找到合适的位置
-        my_free_list = free_list + FREELIST_INDEX(n);
+        size_t index = FREELIST_INDEX(n);
+        tcache.frees[index].add(1);
+        my_free_list = tcache.free_list + index;
         // 将 q 的这个区块插入到 free list 头中
         q->free_list_link = *my_free_list;
         *my_free_list = q;
+        tcache.length[index].add(1);
+        // 线程缓存过长，批量归还一部分给中心内存池，线程退出之后 limit 为 0，每次都会归还
+        if (tcache.length[index].get() > tcache.limit[index])
+            release(index);
     }
 
     static void * reallocate(void *p, size_t old_size, size_t new_size);
 
+    // 申请 n 个字节时实际得到的区块大小，即 n 所在 size class 的区块大小
+    static size_t good_size(size_t n) {
+        return 0 == n || n > MAX_BYTES ? n : CLASS_SIZE(FREELIST_INDEX(n));
+    }
+
+    /**
+     * 分配按 align 对齐的内存，align 为 2 的幂
+     * 从区块大小是 align 倍数的 size class 中分配，这些区块的自然对齐不小于 align
+     * 没有合适的 size class 时交给一级配置器
+     * 必须用相同的 n 和 align 调用 deallocate_aligned 归还
+     */
+    static void * allocate_aligned(size_t n, size_t align) {
+        if (align <= ALIGN) return allocate(n);
+        size_t index = ALIGNED_INDEX(n, align);
+        if (NFREELISTS != index) return allocate(CLASS_SIZE(index));
+        if (!tcache.registered) attach_cache();
+        void *r = large_alloc::allocate_aligned(n, align);
+        tcache.large_allocations.add(1);
+        tcache.large_bytes.add(n);
+        if (tcache.retired) flush_retired();
+        return r;
+    }
+
+    static void deallocate_aligned(void *p, size_t n, size_t align) {
+        if (align <= ALIGN) {
+            deallocate(p, n);
+            return;
+        }
+        size_t index = ALIGNED_INDEX(n, align);
+        if (NFREELISTS != index) {
+            deallocate(p, CLASS_SIZE(index));
+            return;
+        }
+        if (!tcache.registered) attach_cache();
+        large_alloc::deallocate_aligned(p, n, align);
+        tcache.large_frees.add(1);
+        tcache.large_bytes.sub(n);
+        if (tcache.retired) flush_retired();
+    }
+
 };
 
 // 初始化静态变量
-char * default_alloc_template::start_free = nullptr;
-char * default_alloc_template::end_free = nullptr;
-size_t default_alloc_template::heap_size = 0;
-
-default_alloc_template::obj * volatile 
-default_alloc_template::free_list[default_alloc_template::NFREELISTS] = {
-    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, 
-    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
-};
+template <typename SizeClass, typename ChunkSource>
+char * pool_alloc_template<SizeClass, ChunkSource>::start_free = nullptr;
+template <typename SizeClass, typename ChunkSource>
+char * pool_alloc_template<SizeClass, ChunkSource>::end_free = nullptr;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::heap_size = 0;
+
+template <typename SizeClass, typename ChunkSource>
+std::mutex pool_alloc_template<SizeClass, ChunkSource>::pool_lock;
+
+template <typename SizeClass, typename ChunkSource>
+thread_local typename pool_alloc_template<SizeClass, ChunkSource>::thread_cache
+pool_alloc_template<SizeClass, ChunkSource>::tcache;
+template <typename SizeClass, typename ChunkSource>
+thread_local typename pool_alloc_template<SizeClass, ChunkSource>::thread_cache_reaper
+pool_alloc_template<SizeClass, ChunkSource>::reaper;
+
+// 以下数组都是零初始化
+template <typename SizeClass, typename ChunkSource>
+typename pool_alloc_template<SizeClass, ChunkSource>::obj *
+pool_alloc_template<SizeClass, ChunkSource>::free_list[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::free_list_length[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+typename pool_alloc_template<SizeClass, ChunkSource>::thread_cache *
+pool_alloc_template<SizeClass, ChunkSource>::caches = nullptr;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::refills[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::refilled_objs[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::releases[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::chunk_allocs[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::retired_allocations[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::retired_frees[NFREELISTS];
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::retired_large_allocations = 0;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::retired_large_frees = 0;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::retired_large_bytes = 0;
+
+template <typename SizeClass, typename ChunkSource>
+typename pool_alloc_template<SizeClass, ChunkSource>::chunk_header *
+pool_alloc_template<SizeClass, ChunkSource>::chunks = nullptr;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::nchunks = 0;
+template <typename SizeClass, typename ChunkSource>
+typename pool_alloc_template<SizeClass, ChunkSource>::span *
+pool_alloc_template<SizeClass, ChunkSource>::spans = nullptr;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::nspans = 0;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::spans_capacity = 0;
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::trimmed_bytes = 0;
+
+template <typename SizeClass, typename ChunkSource>
+std::atomic<int> pool_alloc_template<SizeClass, ChunkSource>::refill_min_objs(4);
+template <typename SizeClass, typename ChunkSource>
+std::atomic<int> pool_alloc_template<SizeClass, ChunkSource>::refill_max_objs(128);
+template <typename SizeClass, typename ChunkSource>
+std::atomic<size_t> pool_alloc_template<SizeClass, ChunkSource>::refill_max_bytes(64 * 1024);
+
+template <typename SizeClass, typename ChunkSource>
+void pool_alloc_template<SizeClass, ChunkSource>::attach_cache() {
+    (void) &reaper;     // 第一次使用 reaper，线程退出时会调用它的析构函数
+    std::lock_guard<std::mutex> guard(pool_lock);
+    tcache.prev = nullptr;
+    tcache.next = caches;
+    if (caches) caches->prev = &tcache;
+    caches = &tcache;
+    tcache.registered = true;
+}
+
+/**
+ * 线程退出时调用
+ * 将线程缓存中所有链表整体接到中心内存池对应的链表上
+ * 线程的计数累加到 retired_* 中，并将线程缓存移出 caches 链表
+ */
+template <typename SizeClass, typename ChunkSource>
+pool_alloc_template<SizeClass, ChunkSource>::thread_cache_reaper::~thread_cache_reaper() {
+    std::lock_guard<std::mutex> guard(pool_lock);
+    flush_cache();
+    retire_counters();
+
+    if (tcache.prev) tcache.prev->next = tcache.next;
+    else caches = tcache.next;
+    if (tcache.next) tcache.next->prev = tcache.prev;
+    tcache.retired = true;
+    // 之后每次 deallocate 都超过 limit，进入 release 归还中心内存池
+    for (size_t i = 0; i < NFREELISTS; ++i)
+        tcache.limit[i] = 0;
+}
+
+template <typename SizeClass, typename ChunkSource>
+void pool_alloc_template<SizeClass, ChunkSource>::retire_counters() {
+    for (size_t i = 0; i < NFREELISTS; ++i) {
+        retired_allocations[i] += tcache.allocations[i].get();
+        retired_frees[i] += tcache.frees[i].get();
+        tcache.allocations[i].value.store(0, std::memory_order_relaxed);
+        tcache.frees[i].value.store(0, std::memory_order_relaxed);
+    }
+    retired_large_allocations += tcache.large_allocations.get();
+    retired_large_frees += tcache.large_frees.get();
+    retired_large_bytes += tcache.large_bytes.get();
+    tcache.large_allocations.value.store(0, std::memory_order_relaxed);
+    tcache.large_frees.value.store(0, std::memory_order_relaxed);
+    tcache.large_bytes.value.store(0, std::memory_order_relaxed);
+}
+
+template <typename SizeClass, typename ChunkSource>
+void pool_alloc_template<SizeClass, ChunkSource>::flush_retired() {
+    std::lock_guard<std::mutex> guard(pool_lock);
+    flush_cache();
+    retire_counters();
+}
+
+template <typename SizeClass, typename ChunkSource>
+void pool_alloc_template<SizeClass, ChunkSource>::flush_cache() {
+    for (size_t i = 0; i < NFREELISTS; ++i) {
+        obj * first = tcache.free_list[i];
+        if (nullptr == first) continue;
+        obj * last = first;
+        while (last->free_list_link) last = last->free_list_link;
+        last->free_list_link = free_list[i];
+        free_list[i] = first;
+        free_list_length[i] += tcache.length[i].get();
+        tcache.free_list[i] = nullptr;
+        tcache.length[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename SizeClass, typename ChunkSource>
+typename pool_alloc_template<SizeClass, ChunkSource>::alloc_stats
+pool_alloc_template<SizeClass, ChunkSource>::get_stats() {
+    alloc_stats stats;
+    std::lock_guard<std::mutex> guard(pool_lock);
+    stats.heap_size = heap_size;
+    stats.chunks = nchunks;
+    stats.pool_bytes = end_free - start_free;
+    stats.span_bytes = 0;
+    for (size_t i = 0; i < nspans; ++i)
+        stats.span_bytes += spans[i].bytes;
+    stats.trimmed_bytes = trimmed_bytes;
+    stats.free_list_bytes = 0;
+    stats.large_allocations = retired_large_allocations;
+    stats.large_frees = retired_large_frees;
+    stats.large_bytes = retired_large_bytes;
+    for (size_t i = 0; i < NFREELISTS; ++i) {
+        class_stats & c = stats.classes[i];
+        c.bytes = CLASS_SIZE(i);
+        c.allocations = retired_allocations[i];
+        c.frees = retired_frees[i];
+        c.refills = refills[i];
+        c.refilled_objs = refilled_objs[i];
+        c.releases = releases[i];
+        c.chunk_allocs = chunk_allocs[i];
+        c.free_objs = free_list_length[i];
+    }
+    for (thread_cache * cache = caches; cache; cache = cache->next) {
+        for (size_t i = 0; i < NFREELISTS; ++i) {
+            stats.classes[i].allocations += cache->allocations[i].get();
+            stats.classes[i].frees += cache->frees[i].get();
+            stats.classes[i].free_objs += cache->length[i].get();
+        }
+        stats.large_allocations += cache->large_allocations.get();
+        stats.large_frees += cache->large_frees.get();
+        stats.large_bytes += cache->large_bytes.get();
+    }
+    for (size_t i = 0; i < NFREELISTS; ++i)
+        stats.free_list_bytes += stats.classes[i].free_objs * stats.classes[i].bytes;
+    return stats;
+}
 
 /**
- * 当 free list 为空时，需要调用 refill 来从内存池中获取区块填充到 free list 中
- * 返回一个大小为 n 的对象，并且有时候会为适当的 free list 增加节点
- * 假设 n 已经上调至 8 的倍数
+ * 当线程缓存为空时，需要调用 refill 从中心内存池获取一批区块填充到线程缓存中
+ * 优先取中心 free list 中的区块，中心 free list 为空时再从内存池中切分
+ * 返回一个第 index 个 size class 的区块，其余区块放入线程缓存
+ * 线程缓存为空说明需求大于当前的批量，batch 翻倍
  */
-void * default_alloc_template::refill(size_t n) {
-    int nobjs = 20;
-    // 调用 chunk_alloc 尝试从内存池中获取 nobjs 个区块
-    char * chunk = chunk_alloc(n, nobjs);
-    // 如果只获取一个区块，则直接返回，将这个区块给调用者
-    if (1 == nobjs) return chunk;
-    // 否则调整 free list，加入新节点
-    obj * volatile * my_free_list;
-    my_free_list = free_list + FREELIST_INDEX(n);
-    obj * current_obj;
-    obj * next_obj;
+template <typename SizeClass, typename ChunkSource>
+void * pool_alloc_template<SizeClass, ChunkSource>::refill(size_t index) {
+    size_t n = CLASS_SIZE(index);
+    int & batch = tcache.batch[index];
+    int max_objs = max_batch(index);
+    if (0 == batch) batch = refill_min_objs.load(std::memory_order_relaxed);
+    else batch *= 2;
+    if (batch > max_objs) batch = max_objs;
+    // 线程已经退出则只取一个区块，避免区块滞留在不会再归还的缓存中
+    tcache.limit[index] = tcache.retired ? 0 : 2 * batch;
+    int nobjs = tcache.retired ? 1 : batch;
     obj * result;
-    result = (obj*) chunk;      // 第一块将会返回给调用者使用
-    *my_free_list = next_obj = (obj*)(chunk + n);
-    for (int i = 1; ; ++i) {    // 从 1 开始，第 0 个作为 result 返回
-        current_obj = next_obj;
-        next_obj = (obj*)((char*)next_obj + n);
-        if (nobjs - 1 == i) {
-            current_obj->free_list_link = nullptr;
-            break;
+    char * chunk = nullptr;
+    if (!tcache.registered) attach_cache();
+    {
+        std::lock_guard<std::mutex> guard(pool_lock);
+        if (tcache.retired) retire_counters();
+        ++refills[index];
+        result = free_list[index];
+        if (nullptr != result) {
+            // 从中心 free list 的头部摘下至多 nobjs 个区块
+            obj * last = result;
+            int i = 1;
+            for ( ; i < nobjs && last->free_list_link; ++i)
+                last = last->free_list_link;
+            free_list[index] = last->free_list_link;
+            last->free_list_link = nullptr;
+            nobjs = i;
+            free_list_length[index] -= nobjs;
+        }
+        else {
+            // 调用 chunk_alloc 尝试从内存池中获取 nobjs 个区块
+            chunk = chunk_alloc(n, nobjs);
+        }
+        refilled_objs[index] += nobjs;
+    }
+
+    if (nullptr != chunk) {
+        // 如果只获取一个区块，则直接返回，将这个区块给调用者
+        if (1 == nobjs) return chunk;
+        // 否则在锁外将区块串成链表，这块内存此时只属于本线程
+        obj * current_obj;
+        obj * next_obj;
+        result = (obj*) chunk;      // 第一块将会返回给调用者使用
+        next_obj = (obj*)(chunk + n);
+        result->free_list_link = next_obj;
+        for (int i = 1; ; ++i) {    // 从 1 开始，第 0 个作为 result 返回
+            current_obj = next_obj;
+            next_obj = (obj*)((char*)next_obj + n);
+            if (nobjs - 1 == i) {
+                current_obj->free_list_link = nullptr;
+                break;
+            }
+            current_obj->free_list_link = next_obj;
         }
-        current_obj->free_list_link = next_obj;
     }
+    // 第一块返回给调用者，其余放入线程缓存 (此时线程缓存的这个链表为空)
+    tcache.free_list[index] = result->free_list_link;
+    tcache.length[index].value.store(nobjs - 1, std::memory_order_relaxed);
     return result;
 }
 
-// size 已经上调至 8 的倍数
+/**
+ * 线程缓存中的链表超过 limit 时调用
+ * 还没有 refill 过的线程 (例如只释放其他线程分配的区块) 先设置初始的 batch
+ * 否则说明释放多于分配，batch 减半，链表只保留 batch 个区块，其余归还中心内存池
+ */
+template <typename SizeClass, typename ChunkSource>
+void pool_alloc_template<SizeClass, ChunkSource>::release(size_t index) {
+    if (tcache.retired) {
+        flush_retired();
+        return;
+    }
+    int & batch = tcache.batch[index];
+    int max_objs = max_batch(index);
+    if (0 == batch) {
+        // 只释放不分配的线程也要注册，否则退出时缓存中的区块和计数都会丢失
+        if (!tcache.registered) attach_cache();
+        batch = refill_min_objs.load(std::memory_order_relaxed);
+        if (batch > max_objs) batch = max_objs;
+        tcache.limit[index] = 2 * batch;
+        if (tcache.length[index].get() <= tcache.limit[index]) return;
+    }
+    else {
+        batch /= 2;
+        int min_objs = refill_min_objs.load(std::memory_order_relaxed);
+        if (batch < min_objs) batch = min_objs;
+        if (batch > max_objs) batch = max_objs;
+        tcache.limit[index] = 2 * batch;
+    }
+    size_t count = tcache.length[index].get() - batch;
+
+    obj * first = tcache.free_list[index];
+    obj * last = first;
+    // 在锁外找到要归还的 count 个区块
+    for (size_t i = 1; i < count; ++i)
+        last = last->free_list_link;
+    tcache.free_list[index] = last->free_list_link;
+    tcache.length[index].sub(count);
+
+    std::lock_guard<std::mutex> guard(pool_lock);
+    last->free_list_link = free_list[index];
+    free_list[index] = first;
+    free_list_length[index] += count;
+    ++releases[index];
+}
+
+// size 是某个 size class 的区块大小
 // nobjs 是传递的引用
-char* default_alloc_template::chunk_alloc(size_t size, int& nobjs) {
+// 调用者持有 pool_lock
+template <typename SizeClass, typename ChunkSource>
+char* pool_alloc_template<SizeClass, ChunkSource>::chunk_alloc(size_t size, int& nobjs) {
     char *result;
     size_t total_bytes = size * nobjs;
-    size_t bytes_left = end_free - start_free; // 内存池剩余空间
+    // 切分的起始位置按区块的自然对齐对齐，跳过的零头编入适当的 free list
+    char *aligned = (char *) _align_up((size_t) start_free, CLASS_ALIGN(size));
+    // 内存池对齐之后的剩余空间
+    size_t bytes_left = aligned < end_free ? end_free - aligned : 0;
 
     if (bytes_left >= total_bytes) {
         // 内存池剩余空间完全满足需求量
+        stash_leftover(aligned);
         result = start_free;
         start_free += total_bytes;
         return (result);
@@ -239,6 +857,7 @@ char* default_alloc_template::chunk_alloc(size_t size, int& nobjs) {
         // 内存池剩余空间不能完全满足需求量，但足够供应一个及以上的区块
         nobjs = bytes_left/size;
         total_bytes = nobjs * size;
+        stash_leftover(aligned);
         result = start_free;
         start_free += total_bytes;
         return (result);
@@ -246,32 +865,38 @@ char* default_alloc_template::chunk_alloc(size_t size, int& nobjs) {
         // 内存池剩余空间连一个区块的大小都无法满足
         size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);
         // 以下试着让内存池中的残余零头还有利用价值
-        if (bytes_left > 0) {
-            // 内存池内还有一些零头，先分配给适当的 free list
-            obj * volatile * my_free_list = free_list + FREELIST_INDEX(bytes_left);
-            // 调整 free list, 将内存池中的残余空间加入
-            ((obj*)start_free)->free_list_link = *my_free_list;
-            *my_free_list = (obj*) start_free;
+        stash_leftover(end_free);
+
+        start_free = end_free = nullptr;
+        // 优先使用 trim() 留下的空闲区域
+        for (size_t i = 0; i < nspans; ++i) {
+            if (spans[i].bytes >= size) {
+                start_free = spans[i].start;
+                end_free = start_free + spans[i].bytes;
+                spans[i] = spans[--nspans];
+                return (chunk_alloc(size, nobjs));
+            }
         }
 
         // 配置 heap 空间，用来补充内存池
-        start_free = (char *)malloc(bytes_to_get);
+        start_free = new_chunk(bytes_to_get, false);
         if (nullptr == start_free) {
-            // heap 空间不足，malloc 失败
-            int i;
-            obj * volatile * my_free_list;
+            // heap 空间不足，ChunkSource 分配失败
+            size_t i;
+            obj ** my_free_list;
             obj * p;
             // 使用已经拥有的东西，而不是去尝试分配更小的区块
             // 因为那样会在多进程机器上容易导致灾难
             // 在 free list 找到一块未被使用并且足够大的区块
-            for (i = size; i <= MAX_BYTES; i += ALIGN) {
-                my_free_list = free_list + FREELIST_INDEX(i);
+            for (i = FREELIST_INDEX(size); i < NFREELISTS; ++i) {
+                my_free_list = free_list + i;
                 p = *my_free_list;
                 if (p != nullptr) {     // free list 中还有区块
                     // 调整 free list 释放出未用的区块
                     *my_free_list = p->free_list_link;
+                    --free_list_length[i];
                     start_free = (char*) p;
-                    end_free = start_free + i;
+                    end_free = start_free + CLASS_SIZE(i);
                     // 递归调用自己，为了修正 nobjs 
                     return (chunk_alloc(size, nobjs));
                     // 任何残余零头都会被编入适当的 free list 中
@@ -279,25 +904,216 @@ char* default_alloc_template::chunk_alloc(size_t size, int& nobjs) {
             }
             end_free = nullptr;     // 没有内存可以用了
             // 调用一级配置器，看看oom机制能否尽点力
-            start_free = (char *)first_alloc_template::allocate(bytes_to_get);
+            start_free = new_chunk(bytes_to_get, true);
             // 这会导致抛出异常
         }
 
         heap_size += bytes_to_get;
+        ++chunk_allocs[FREELIST_INDEX(size)];
         end_free = start_free + bytes_to_get;
         // 递归调用自己，为了修正 nobjs
         return (chunk_alloc(size, nobjs));
     }
 }
 
-void * default_alloc_template::reallocate(void *p, size_t old_size, size_t new_size) {
+/**
+ * 零头是 ALIGN 的倍数，但不一定恰好是某个 size class 的大小
+ * 每次切下不超过零头、并且在当前位置满足自然对齐的最大 size class 的区块
+ * 最小的 size class 的自然对齐是 ALIGN，总能切下，直到零头不足最小的区块
+ */
+template <typename SizeClass, typename ChunkSource>
+void pool_alloc_template<SizeClass, ChunkSource>::stash_leftover(char * last) {
+    size_t bytes_left = last - start_free;
+    while (bytes_left >= CLASS_SIZE(0)) {
+        // 对齐跳过的部分可能使零头超过 MAX_BYTES
+        size_t index = bytes_left > MAX_BYTES ? NFREELISTS - 1 : FREELIST_INDEX(bytes_left);
+        if (CLASS_SIZE(index) > bytes_left) --index;
+        while ((size_t) start_free & (CLASS_ALIGN(CLASS_SIZE(index)) - 1)) --index;
+        obj ** my_free_list = free_list + index;
+        // 调整 free list, 将内存池中的残余空间加入
+        ((obj*)start_free)->free_list_link = *my_free_list;
+        *my_free_list = (obj*) start_free;
+        ++free_list_length[index];
+        start_free += CLASS_SIZE(index);
+        bytes_left -= CLASS_SIZE(index);
+    }
+}
+
+template <typename SizeClass, typename ChunkSource>
+char * pool_alloc_template<SizeClass, ChunkSource>::new_chunk(size_t & bytes, bool use_first_alloc) {
+    const size_t granularity = ChunkSource::GRANULARITY;
+    size_t total = (CHUNK_HEADER + bytes + granularity - 1) / granularity * granularity;
+    chunk_header * chunk = use_first_alloc
+        ? (chunk_header *) large_alloc::allocate(total)
+        : (chunk_header *) ChunkSource::allocate(total);
+    if (nullptr == chunk) return nullptr;
+    bytes = (total - CHUNK_HEADER) & ~(ALIGN - 1);
+    chunk->bytes = bytes;
+    chunk->next = chunks;
+    chunks = chunk;
+    ++nchunks;
+    return (char *) chunk + CHUNK_HEADER;
+}
+
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::trim() {
+    std::lock_guard<std::mutex> guard(pool_lock);
+    flush_cache();
+
+    // 收集所有空闲区域：free list 中的区块，spans，以及内存池的剩余空间
+    size_t nitems = nspans + 1;
+    for (size_t i = 0; i < NFREELISTS; ++i)
+        nitems += free_list_length[i];
+    free_range * items = (free_range *) malloc(nitems * sizeof(free_range));
+    chunk_header ** sorted = (chunk_header **) malloc(nchunks * sizeof(chunk_header *));
+    // trim 之后 span 的个数不会超过 nitems，提前准备好空间，之后就不会失败
+    if (nullptr != items && nullptr != sorted && spans_capacity < nitems) {
+        span * p = (span *) realloc(spans, nitems * sizeof(span));
+        if (nullptr != p) {
+            spans = p;
+            spans_capacity = nitems;
+        }
+    }
+    if (nullptr == items || nullptr == sorted || spans_capacity < nitems) {
+        ::free(items);
+        ::free(sorted);
+        return 0;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < NFREELISTS; ++i) {
+        for (obj * p = free_list[i]; p; p = p->free_list_link) {
+            free_range r = { (char *) p, CLASS_SIZE(i), i, false };
+            items[n++] = r;
+        }
+        free_list[i] = nullptr;
+        free_list_length[i] = 0;
+    }
+    for (size_t i = 0; i < nspans; ++i) {
+        free_range r = { spans[i].start, spans[i].bytes, SPAN, true };
+        items[n++] = r;
+    }
+    if (end_free != start_free) {
+        free_range r = { start_free, (size_t) (end_free - start_free), SPAN, false };
+        items[n++] = r;
+    }
+    nspans = 0;
+    start_free = end_free = nullptr;
+
+    size_t k = 0;
+    for (chunk_header * c = chunks; c; c = c->next)
+        sorted[k++] = c;
+    std::sort(items, items + n,
+              [](const free_range & a, const free_range & b) { return a.start < b.start; });
+    std::sort(sorted, sorted + nchunks);
+
+    // 逐个 chunk 统计空闲的字节数，items 和 sorted 都是按地址排好序的
+    size_t released = 0;
+    size_t kept = 0;
+    k = 0;
+    for (size_t c = 0; c < nchunks; ++c) {
+        char * begin = (char *) sorted[c] + CHUNK_HEADER;
+        char * end = begin + sorted[c]->bytes;
+        while (k < n && items[k].start < begin) ++k;
+        size_t first = k;
+        size_t free_bytes = 0;
+        for ( ; k < n && items[k].start < end; ++k)
+            free_bytes += items[k].bytes;
+        if (free_bytes == sorted[c]->bytes) {
+            // 整个 chunk 都是空闲的，归还给 heap
+            for (size_t i = first; i < k; ++i)
+                items[i].index = DROPPED;
+            heap_size -= sorted[c]->bytes;
+            released += CHUNK_HEADER + sorted[c]->bytes;
+            ChunkSource::deallocate(sorted[c], CHUNK_HEADER + sorted[c]->bytes);
+        }
+        else {
+            sorted[kept++] = sorted[c];
+            released += purge(items + first, items + k);
+        }
+    }
+    // 重新串起剩下的 chunk
+    chunks = nullptr;
+    for (size_t c = kept; c-- > 0; ) {
+        sorted[c]->next = chunks;
+        chunks = sorted[c];
+    }
+    nchunks = kept;
+
+    // 从高地址到低地址插入，重建后的 free list 按地址升序排列
+    for (size_t i = n; i-- > 0; ) {
+        if (DROPPED == items[i].index) continue;
+        if (SPAN == items[i].index) {
+            span s = { items[i].start, items[i].bytes };
+            spans[nspans++] = s;
+        }
+        else {
+            obj * p = (obj *) items[i].start;
+            p->free_list_link = free_list[items[i].index];
+            free_list[items[i].index] = p;
+            ++free_list_length[items[i].index];
+        }
+    }
+    ::free(items);
+    ::free(sorted);
+    trimmed_bytes += released;
+    return released;
+}
+
+template <typename SizeClass, typename ChunkSource>
+size_t pool_alloc_template<SizeClass, ChunkSource>::purge(free_range * first, free_range * last) {
+    size_t released = 0;
+    const size_t page = _page_size();
+    while (first != last) {
+        // [first, run) 是一段地址连续的空闲区域
+        free_range * run = first + 1;
+        char * run_end = first->start + first->bytes;
+        while (run != last && run->start == run_end) {
+            run_end += run->bytes;
+            ++run;
+        }
+        // 只有一个已经 madvise 过的 span，不需要再处理
+        if (run == first + 1 && first->purged) {
+            first = run;
+            continue;
+        }
+        char * page_begin = (char *) (((size_t) first->start + page - 1) & ~(page - 1));
+        char * page_end = (char *) ((size_t) run_end & ~(page - 1));
+        if (page_begin < page_end) {
+            // 与 [page_begin, page_end) 重叠的区域合并为一个 span
+            free_range * a = first;
+            while (a->start + a->bytes <= page_begin) ++a;
+            free_range * b = a + 1;
+            while (b != run && b->start < page_end) {
+                b->index = DROPPED;
+                ++b;
+            }
+            a->bytes = (b - 1)->start + (b - 1)->bytes - a->start;
+            a->index = SPAN;
+            a->purged = true;
+            ChunkSource::purge(page_begin, page_end - page_begin);
+            released += page_end - page_begin;
+        }
+        first = run;
+    }
+    return released;
+}
+
+template <typename SizeClass, typename ChunkSource>
+void * pool_alloc_template<SizeClass, ChunkSource>::reallocate(void *p, size_t old_size, size_t new_size) {
     void *result;
     size_t copy_size;
 
     if (old_size > MAX_BYTES && new_size > MAX_BYTES) {
-        return realloc(p, new_size);
+        result = large_alloc::reallocate(p, old_size, new_size);
+        if (!tcache.registered) attach_cache();
+        tcache.large_bytes.add(new_size);
+        tcache.large_bytes.sub(old_size);
+        if (tcache.retired) flush_retired();
+        return result;
     }
-    if (ROUND_UP(old_size) == ROUND_UP(new_size)) return p;
+    if (old_size <= MAX_BYTES && new_size <= MAX_BYTES
+        && FREELIST_INDEX(old_size) == FREELIST_INDEX(new_size)) return p;
     result = allocate(new_size);
     copy_size = new_size > old_size ? old_size : new_size;
     memcpy(result, p, copy_size);
@@ -305,6 +1121,48 @@ void * default_alloc_template::reallocate(void *p, size_t old_size, size_t new_s
     return result;
 }
 
+typedef pool_alloc_template<linear_size_class<8, 128> > default_alloc_template;
+typedef pool_alloc_template<geometric_size_class<4096> > geometric_alloc_template;
+
+/**
+ * 后台回收线程
+ * 每隔 interval 调用一次 Alloc::trim()，析构时停止并等待线程结束
+ */
+template <typename Alloc>
+class background_trimmer {
+public:
+    explicit background_trimmer(std::chrono::milliseconds interval)
+        : interval(interval), stopping(false), worker(&background_trimmer::run, this) { }
+
+    background_trimmer(const background_trimmer &) = delete;
+    background_trimmer& operator= (const background_trimmer &) = delete;
+
+    ~background_trimmer() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        worker.join();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!wakeup.wait_for(guard, interval, [this] { return stopping; })) {
+            guard.unlock();
+            Alloc::trim();
+            guard.lock();
+        }
+    }
+
+    std::chrono::milliseconds interval;
+    std::mutex lock;
+    std::condition_variable wakeup;
+    bool stopping;
+    std::thread worker;     // 最后初始化，线程启动时其他成员都已经构造好
+};
+
 }
 
 #endif // MINISTL_ALLOC_H
\ No newline at end of file
@@ -31,6 +31,8 @@
  *      等同于 new(const void* p) T(x)
  * void allocator::destroy(pointer p)
  *      等同于 p->~T()
+ * pointer allocator::reallocate(pointer p, size_type old_n, size_type new_n)
+ *      可选，把 old_n 个元素的空间调整为 new_n 个，内容按字节搬移，只用于可以平凡重定位的 T
  */
 
 
@@ -42,9 +44,12 @@
 #include <cstdlib>      // for exit()
 #include <climits>      // for UINT_MAX
 #include <iostream>     // for cerr
+#include <cstring>      // for memcpy
+#include <utility>      // for declval
 #include "alloc.h"
 #include "constructor.h"
 #include "util.h"       // for move
+#include "heap_profiler.h"
 
 namespace ministl {
 
@@ -76,6 +81,43 @@ inline void _deallocate(T* buffer) {
 
 
 
+// 检查 A 是否提供 reallocate(P p, size_t old_n, size_t new_n)
+// 既可以检查静态接口的 Alloc (P 为 void*)，也可以检查 allocator 对象 (P 为 T*)
+template <typename A, typename P>
+struct has_reallocate {
+private:
+    template <typename U>
+    static char test(decltype(std::declval<U&>().reallocate(std::declval<P>(), size_t(), size_t())) *);
+    template <typename U>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<A>(0)) == 1;
+};
+
+// 检查 A 是否提供静态的 good_size(n)
+template <typename A>
+struct has_good_size {
+private:
+    template <typename U>
+    static char test(decltype(U::good_size(size_t())) *);
+    template <typename U>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<A>(0)) == 1;
+};
+
+template <typename A>
+inline size_t _good_capacity_aux(size_t n, true_type) { return A::good_size(n); }
+
+template <typename A>
+inline size_t _good_capacity_aux(size_t n, false_type) { return n; }
+
+// 向配置器 A 申请 n 个元素时实际能容纳的元素个数，A 没有 good_size 时为 n
+template <typename A>
+inline size_t _good_capacity(size_t n) {
+    return _good_capacity_aux<A>(n, typename bool_type<has_good_size<A>::value>::type());
+}
+
 // 这里 allocator 中 allocate 和 deallocate 使用了 alloc.h 文件中内存池的实现
 template<typename T, typename Alloc = default_alloc_template>
 class allocator {
@@ -94,26 +136,61 @@ public:
     // 每个节点中的值也需要一个分配器。
     template <class U>
     struct rebind {
-        typedef allocator<U> other;
+        typedef allocator<U, Alloc> other;
     };
 
+    allocator() { }
+
+    // rebind 得到的配置器可以互相转换，例如 vector<bool> 保存的是 allocator<unsigned long>
+    template <typename U>
+    allocator(const allocator<U, Alloc>&) { }
+
     // hint used for locality
     static pointer allocate(size_type n, const void* hint = 0) {
         // return _allocate((difference_type) n, (pointer) 0 );
-        return 0 == n ? nullptr : (pointer) Alloc::allocate(n * sizeof(value_type));
+        if (0 == n) return nullptr;
+        pointer p = (pointer) allocate_bytes(n * sizeof(value_type), over_aligned());
+        _MINISTL_PROFILE_ALLOCATE(T, Alloc, p, n * sizeof(value_type));
+        return p;
     }
 
     static pointer allocate(void) {
-        return (pointer) Alloc::allocate(sizeof(value_type));
+        pointer p = (pointer) allocate_bytes(sizeof(value_type), over_aligned());
+        _MINISTL_PROFILE_ALLOCATE(T, Alloc, p, sizeof(value_type));
+        return p;
     }
 
     void deallocate(pointer p, size_type n) { 
         // _deallocate(p); 
-        if (0 != n) Alloc::deallocate(p, n * sizeof(value_type));
+        if (0 == n) return;
+        _MINISTL_PROFILE_DEALLOCATE(p);
+        deallocate_bytes(p, n * sizeof(value_type), over_aligned());
     }
 
     void deallocate(pointer p) {
-        Alloc::deallocate(p, sizeof(value_type));
+        _MINISTL_PROFILE_DEALLOCATE(p);
+        deallocate_bytes(p, sizeof(value_type), over_aligned());
+    }
+
+    /**
+     * 把 p 处 old_n 个元素的空间调整为 new_n 个，前 min(old_n, new_n) 个元素按字节搬移
+     * 只能用于可以平凡重定位的 T (见 is_trivially_relocatable)
+     * Alloc 提供 reallocate 时交给它，大区块由 realloc / mremap 原地扩展或移动页面，不需要复制
+     * 失败时抛出异常，p 保持不变
+     */
+    static pointer reallocate(pointer p, size_type old_n, size_type new_n) {
+        if (0 == old_n) return allocate(new_n);
+        pointer r = (pointer) reallocate_bytes(p, old_n * sizeof(value_type),
+                                               new_n * sizeof(value_type), can_reallocate());
+        _MINISTL_PROFILE_DEALLOCATE(p);
+        _MINISTL_PROFILE_ALLOCATE(T, Alloc, r, new_n * sizeof(value_type));
+        return r;
+    }
+
+    // 申请 n 个元素时实际得到的区块能容纳的元素个数，不小于 n
+    // Alloc 不要求提供 good_size，没有时为 n
+    static size_type good_size(size_type n) {
+        return over_aligned::value ? n : _good_capacity<Alloc>(n * sizeof(value_type)) / sizeof(value_type);
     }
 
     void construct(pointer p);
@@ -139,6 +216,44 @@ public:
         return size_type(UINT_MAX/sizeof(T));
     }
 
+private:
+    // Alloc::allocate 只保证 MIN_ALIGN 字节对齐
+    // alignof(T) 更大时 (例如 alignas(64) 的结构体、__m256) 使用 Alloc::allocate_aligned
+    static const size_t MIN_ALIGN = 8;
+
+    struct over_aligned : bool_type<(alignof(T) > MIN_ALIGN)>::type { };
+
+    static void * allocate_bytes(size_t bytes, false_type) {
+        return Alloc::allocate(bytes);
+    }
+
+    static void * allocate_bytes(size_t bytes, true_type) {
+        return Alloc::allocate_aligned(bytes, alignof(T));
+    }
+
+    static void deallocate_bytes(void *p, size_t bytes, false_type) {
+        Alloc::deallocate(p, bytes);
+    }
+
+    static void deallocate_bytes(void *p, size_t bytes, true_type) {
+        Alloc::deallocate_aligned(p, bytes, alignof(T));
+    }
+
+    // Alloc::reallocate 不保证超过 MIN_ALIGN 的对齐，这时只能重新分配
+    struct can_reallocate : bool_type<!over_aligned::value
+                                      && has_reallocate<Alloc, void *>::value>::type { };
+
+    static void * reallocate_bytes(void *p, size_t old_bytes, size_t new_bytes, true_type) {
+        return Alloc::reallocate(p, old_bytes, new_bytes);
+    }
+
+    static void * reallocate_bytes(void *p, size_t old_bytes, size_t new_bytes, false_type) {
+        void *r = allocate_bytes(new_bytes, over_aligned());
+        memcpy(r, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+        deallocate_bytes(p, old_bytes, over_aligned());
+        return r;
+    }
+
 };
 
 template <typename T, typename Alloc>
@@ -159,12 +274,30 @@ void allocator<T, Alloc>::construct(pointer p, T&& value) {
     ministl::construct(p, ministl::move(value));
 }
 
+template <typename T, typename Alloc>
+template <typename ... Args>
+void allocator<T, Alloc>::construct(pointer p, Args&& ... args) {
+    _MINISTL_DEBUG("ministl::allocator::construct at %p by args\n", p);
+    ministl::construct(p, ministl::forward<Args>(args)...);
+}
+
 template <typename T, typename Alloc>
 void allocator<T, Alloc>::destroy(pointer p) {
     _MINISTL_DEBUG("ministl::allocator::destroy at %p\n", p);
     ministl::destroy(p);
 }
 
+// Alloc 的接口都是静态函数，同一个 Alloc 的 allocator 分配的内存可以互相归还
+template <typename T, typename U, typename Alloc>
+inline bool operator==(const allocator<T, Alloc>&, const allocator<U, Alloc>&) {
+    return true;
+}
+
+template <typename T, typename U, typename Alloc>
+inline bool operator!=(const allocator<T, Alloc>&, const allocator<U, Alloc>&) {
+    return false;
+}
+
 
 }
 
@@ -0,0 +1,181 @@
+#ifndef MINISTL_ARENA_H
+#define MINISTL_ARENA_H
+
+#include <stddef.h>
+#include <string.h>
+#include "alloc.h"
+
+namespace ministl {
+
+/**
+ * 单调 (monotonic) 内存区，也叫 bump pointer 配置器
+ * 从一级配置器申请一块块内存 (block)，allocate 只需要移动指针
+ * deallocate 什么也不做，所有内存在 release() 或析构时一次性归还
+ * 每个新 block 的大小是上一个的两倍，release() 会保留最大的一个 block 以便复用
+ * 适合一批同时创建、同时销毁的对象，例如一次请求中用到的所有 vector
+ * 不是线程安全的，一个 monotonic_arena 只应该在一个线程中使用
+ */
+class monotonic_arena {
+
+public:
+    // 默认对齐，与 malloc 保证的对齐相同
+    static const size_t ALIGN = alignof(max_align_t);
+
+    explicit monotonic_arena(size_t initial_bytes = 4096)
+        : head(nullptr), cur(nullptr), end(nullptr),
+          next_bytes(initial_bytes < 64 ? 64 : initial_bytes), used(0) { }
+
+    monotonic_arena(const monotonic_arena &) = delete;
+    monotonic_arena& operator= (const monotonic_arena &) = delete;
+
+    ~monotonic_arena() {
+        release();
+        if (head) malloc_alloc::deallocate(head, head->bytes);
+    }
+
+    void * allocate(size_t n, size_t align = ALIGN) {
+        char * p = (char *) (((size_t) cur + align - 1) & ~(align - 1));
+        // 对齐之后 p 可能已经越过 end，这时 end - p 是负数
+        if (nullptr == cur || p > end || n > (size_t) (end - p)) p = grow(n, align);
+        cur = p + n;
+        used += n;
+        return p;
+    }
+
+    // 逐个对象的回收什么也不做
+    void deallocate(void *, size_t) { }
+
+    /**
+     * p 是最后一次分配的内存并且 block 中还有空间时，直接原地扩展
+     * 否则重新分配并复制
+     */
+    void * reallocate(void *p, size_t old_size, size_t new_size) {
+        if ((char *) p + old_size == cur && new_size <= (size_t) (end - (char *) p)) {
+            cur = (char *) p + new_size;
+            used = used - old_size + new_size;
+            return p;
+        }
+        void *result = allocate(new_size);
+        memcpy(result, p, old_size < new_size ? old_size : new_size);
+        return result;
+    }
+
+    /**
+     * 一次性归还所有内存
+     * 只保留当前 (也是最大的) block，之后的分配直接从这个 block 开始
+     */
+    void release() {
+        if (nullptr == head) return;
+        block * b = head->prev;
+        while (b) {
+            block * prev = b->prev;
+            malloc_alloc::deallocate(b, b->bytes);
+            b = prev;
+        }
+        head->prev = nullptr;
+        cur = (char *) head + HEADER;
+        used = 0;
+    }
+
+    // 已经分配出去的字节数
+    size_t bytes_allocated() const { return used; }
+
+private:
+    struct block {
+        block * prev;
+        size_t bytes;           // 包括 block 头部在内的字节数
+    };
+
+    static const size_t HEADER = (sizeof(block) + ALIGN - 1) & ~(ALIGN - 1);
+
+    // 当前 block 空间不足，申请一个新的 block
+    char * grow(size_t n, size_t align) {
+        size_t bytes = next_bytes;
+        while (bytes < HEADER + n + align) bytes *= 2;
+        block * b = (block *) malloc_alloc::allocate(bytes);
+        b->prev = head;
+        b->bytes = bytes;
+        head = b;
+        end = (char *) b + bytes;
+        next_bytes = bytes * 2;
+        return (char *) (((size_t) b + HEADER + align - 1) & ~(align - 1));
+    }
+
+    block * head;               // 当前 block，prev 指向之前的 block
+    char * cur;                 // 当前 block 中下一次分配的位置
+    char * end;                 // 当前 block 的尾
+    size_t next_bytes;          // 下一个 block 的大小
+    size_t used;
+};
+
+/**
+ * 让 monotonic_arena 可以作为 allocator<T, Alloc> 的 Alloc 参数
+ * allocator 的 Alloc 接口都是静态函数，所以 arena_alloc 从本线程当前的 arena 分配内存
+ * 当前的 arena 由 arena_scope 设置，作用域结束时恢复为之前的 arena
+ * 没有 arena 时 allocate 会抛出 bad_alloc
+ *
+ *     monotonic_arena arena;
+ *     {
+ *         arena_scope scope(arena);
+ *         vector<int, allocator<int, arena_alloc> > v;
+ *         ...
+ *     }
+ *     arena.release();
+ *
+ * 使用 arena 的容器需要在 arena.release() 之前销毁
+ */
+class arena_alloc {
+
+public:
+    static void * allocate(size_t n) {
+        monotonic_arena * arena = current();
+        if (nullptr == arena) { MINISTL_THROW_BAD_ALLOC; }
+        return arena->allocate(n);
+    }
+
+    static void deallocate(void *, size_t) { }
+
+    static void * allocate_aligned(size_t n, size_t align) {
+        monotonic_arena * arena = current();
+        if (nullptr == arena) { MINISTL_THROW_BAD_ALLOC; }
+        return arena->allocate(n, align);
+    }
+
+    static void deallocate_aligned(void *, size_t, size_t) { }
+
+    static void * reallocate(void *p, size_t old_size, size_t new_size) {
+        monotonic_arena * arena = current();
+        if (nullptr == arena) { MINISTL_THROW_BAD_ALLOC; }
+        return arena->reallocate(p, old_size, new_size);
+    }
+
+    static size_t good_size(size_t n) { return n; }
+
+    // 本线程当前的 arena
+    static monotonic_arena *& current() {
+        static thread_local monotonic_arena * arena = nullptr;
+        return arena;
+    }
+
+};
+
+// 在作用域内把 arena 设置为本线程当前的 arena
+class arena_scope {
+
+public:
+    explicit arena_scope(monotonic_arena & arena) : prev(arena_alloc::current()) {
+        arena_alloc::current() = &arena;
+    }
+
+    arena_scope(const arena_scope &) = delete;
+    arena_scope& operator= (const arena_scope &) = delete;
+
+    ~arena_scope() { arena_alloc::current() = prev; }
+
+private:
+    monotonic_arena * prev;
+};
+
+}
+
+#endif // MINISTL_ARENA_H
@@ -0,0 +1,549 @@
+#ifndef MINISTL_BVECTOR_H
+#define MINISTL_BVECTOR_H
+
+#include <climits>          // for CHAR_BIT
+#include <cstring>          // for memcpy, memset
+#include "vector.h"
+
+namespace ministl {
+
+/**
+ * vector<bool> 的特化，每个元素只占一个 bit
+ * 元素按 word (unsigned long) 存放，第 i 个元素是第 i / WORD_BIT 个 word 的第 i % WORD_BIT 位
+ * operator[] 和迭代器返回代理对象 _bit_reference，不能取得单个元素的地址
+ *
+ * 除了 vector 的接口之外，提供按 word 处理的算法：
+ *     count()                  值为 true 的元素个数，使用 popcount
+ *     find_first()             第一个 true 的位置，不存在时返回 npos
+ *     find_next(pos)           pos 之后第一个 true 的位置
+ *     flip()                   所有元素取反
+ *     &= |= ^=                 与同样长度的 vector<bool> 按位运算
+ * 这些算法的循环体只有简单的 word 运算，编译器可以自动向量化 (-O3，或加上 -mavx2)
+ *
+ * 不变式：size() 之后直到容量末尾的位总是 0，count、find 和比较不需要额外处理末尾，
+ * 增加元素时也不需要清零
+ */
+
+typedef unsigned long _bit_word;
+
+enum { _WORD_BIT = int(CHAR_BIT * sizeof(_bit_word)) };
+
+// 代理引用，指向某个 word 中的一位
+struct _bit_reference {
+    _bit_word * p;
+    _bit_word mask;
+
+    _bit_reference(_bit_word * x, _bit_word y) : p(x), mask(y) { }
+
+    operator bool() const { return 0 != (*p & mask); }
+
+    _bit_reference& operator=(bool x) {
+        if (x) *p |= mask;
+        else *p &= ~mask;
+        return *this;
+    }
+
+    _bit_reference& operator=(const _bit_reference& x) {
+        return *this = bool(x);
+    }
+
+    bool operator==(const _bit_reference& x) const {
+        return bool(*this) == bool(x);
+    }
+
+    void flip() { *p ^= mask; }
+};
+
+inline void swap(_bit_reference x, _bit_reference y) {
+    bool tmp = x;
+    x = y;
+    y = tmp;
+}
+
+struct _bit_iterator_base {
+    _bit_word * p;
+    unsigned int offset;
+
+    _bit_iterator_base(_bit_word * x, unsigned int y) : p(x), offset(y) { }
+
+    void bump_up() {
+        if (offset++ == _WORD_BIT - 1) {
+            offset = 0;
+            ++p;
+        }
+    }
+
+    void bump_down() {
+        if (offset-- == 0) {
+            offset = _WORD_BIT - 1;
+            --p;
+        }
+    }
+
+    void incr(ptrdiff_t i) {
+        ptrdiff_t n = i + offset;
+        p += n / _WORD_BIT;
+        n = n % _WORD_BIT;
+        if (n < 0) {
+            n += _WORD_BIT;
+            --p;
+        }
+        offset = (unsigned int) n;
+    }
+
+    bool operator==(const _bit_iterator_base& x) const {
+        return p == x.p && offset == x.offset;
+    }
+    bool operator!=(const _bit_iterator_base& x) const {
+        return !(*this == x);
+    }
+    bool operator<(const _bit_iterator_base& x) const {
+        return p < x.p || (p == x.p && offset < x.offset);
+    }
+    bool operator>(const _bit_iterator_base& x) const { return x < *this; }
+    bool operator<=(const _bit_iterator_base& x) const { return !(x < *this); }
+    bool operator>=(const _bit_iterator_base& x) const { return !(*this < x); }
+};
+
+inline ptrdiff_t operator-(const _bit_iterator_base& x, const _bit_iterator_base& y) {
+    return _WORD_BIT * (x.p - y.p) + x.offset - y.offset;
+}
+
+struct _bit_iterator : public _bit_iterator_base {
+    typedef random_access_iterator_tag  iterator_category;
+    typedef bool                        value_type;
+    typedef ptrdiff_t                   difference_type;
+    typedef _bit_reference*             pointer;
+    typedef _bit_reference              reference;
+    typedef _bit_iterator               iterator;
+
+    _bit_iterator() : _bit_iterator_base(nullptr, 0) { }
+    _bit_iterator(_bit_word * x, unsigned int y) : _bit_iterator_base(x, y) { }
+
+    reference operator*() const { return reference(p, _bit_word(1) << offset); }
+
+    iterator& operator++() {
+        bump_up();
+        return *this;
+    }
+    iterator operator++(int) {
+        iterator tmp = *this;
+        bump_up();
+        return tmp;
+    }
+    iterator& operator--() {
+        bump_down();
+        return *this;
+    }
+    iterator operator--(int) {
+        iterator tmp = *this;
+        bump_down();
+        return tmp;
+    }
+    iterator& operator+=(difference_type i) {
+        incr(i);
+        return *this;
+    }
+    iterator& operator-=(difference_type i) {
+        incr(-i);
+        return *this;
+    }
+    iterator operator+(difference_type i) const {
+        iterator tmp = *this;
+        return tmp += i;
+    }
+    iterator operator-(difference_type i) const {
+        iterator tmp = *this;
+        return tmp -= i;
+    }
+    reference operator[](difference_type i) const { return *(*this + i); }
+};
+
+struct _bit_const_iterator : public _bit_iterator_base {
+    typedef random_access_iterator_tag  iterator_category;
+    typedef bool                        value_type;
+    typedef ptrdiff_t                   difference_type;
+    typedef const bool*                 pointer;
+    typedef bool                        reference;
+    typedef _bit_const_iterator         const_iterator;
+
+    _bit_const_iterator() : _bit_iterator_base(nullptr, 0) { }
+    _bit_const_iterator(_bit_word * x, unsigned int y) : _bit_iterator_base(x, y) { }
+    _bit_const_iterator(const _bit_iterator& x) : _bit_iterator_base(x.p, x.offset) { }
+
+    reference operator*() const { return 0 != (*p & (_bit_word(1) << offset)); }
+
+    const_iterator& operator++() {
+        bump_up();
+        return *this;
+    }
+    const_iterator operator++(int) {
+        const_iterator tmp = *this;
+        bump_up();
+        return tmp;
+    }
+    const_iterator& operator--() {
+        bump_down();
+        return *this;
+    }
+    const_iterator operator--(int) {
+        const_iterator tmp = *this;
+        bump_down();
+        return tmp;
+    }
+    const_iterator& operator+=(difference_type i) {
+        incr(i);
+        return *this;
+    }
+    const_iterator& operator-=(difference_type i) {
+        incr(-i);
+        return *this;
+    }
+    const_iterator operator+(difference_type i) const {
+        const_iterator tmp = *this;
+        return tmp += i;
+    }
+    const_iterator operator-(difference_type i) const {
+        const_iterator tmp = *this;
+        return tmp -= i;
+    }
+    reference operator[](difference_type i) const { return *(*this + i); }
+};
+
+template <typename Alloc, typename Growth>
+class vector<bool, Alloc, Growth> {
+public:
+    typedef bool                    value_type;
+    typedef size_t                  size_type;
+    typedef ptrdiff_t               difference_type;
+    typedef _bit_reference          reference;
+    typedef bool                    const_reference;
+    typedef _bit_reference*         pointer;
+    typedef const bool*             const_pointer;
+    typedef _bit_iterator           iterator;
+    typedef _bit_const_iterator     const_iterator;
+    typedef Alloc                   allocator_type;
+    typedef Growth                  growth_policy;
+    typedef _bit_word               word_type;
+    allocator_type get_allocator() const { return allocator_type(data_allocator); }
+
+    static const size_type npos = size_type(-1);
+
+protected:
+    // 以 word 为单位分配
+    typedef typename Alloc::template rebind<word_type>::other word_allocator;
+
+    word_allocator  data_allocator;
+    word_type *     words;          // 存放元素的 word 数组
+    size_type       nbits;          // 元素个数
+    size_type       nwords;         // 已分配的 word 个数
+
+    static size_type words_for(size_type n) {
+        return (n + _WORD_BIT - 1) / _WORD_BIT;
+    }
+
+    // 把最后一个 word 中 size() 之后的位清零
+    void clear_unused_bits() {
+        if (nbits % _WORD_BIT)
+            words[nbits / _WORD_BIT] &= (_bit_word(1) << (nbits % _WORD_BIT)) - 1;
+    }
+
+    void deallocate() {
+        if (words)
+            data_allocator.deallocate(words, nwords);
+    }
+
+    // word 可以直接按字节搬移，配置器提供 reallocate 时交给它
+    void reallocate_words(size_type len, true_type) {
+        words = data_allocator.reallocate(words, nwords, len);
+    }
+
+    void reallocate_words(size_type len, false_type) {
+        word_type * new_words = data_allocator.allocate(len);
+        if (words) {
+            memcpy(new_words, words, words_for(nbits) * sizeof(word_type));
+            data_allocator.deallocate(words, nwords);
+        }
+        words = new_words;
+    }
+
+    // 把容量改为 len 个 word，新增的 word 清零
+    void reallocate_storage(size_type len) {
+        reallocate_words(len, typename bool_type<has_reallocate<word_allocator,
+                                                 word_type *>::value>::type());
+        size_type used = words_for(nbits);
+        if (len > used)
+            memset(words + used, 0, (len - used) * sizeof(word_type));
+        nwords = len;
+    }
+
+    // 容量至少为 n 个元素，不足时按增长策略扩容
+    void grow_to(size_type n) {
+        if (n > capacity())
+            reallocate_storage(Growth::template next_capacity<word_allocator>(
+                nwords, words_for(n), sizeof(word_type)));
+    }
+
+    void initialize(size_type n, bool value) {
+        words = nullptr;
+        nbits = nwords = 0;
+        if (0 == n) return;
+        nwords = words_for(n);
+        words = data_allocator.allocate(nwords);
+        memset(words, value ? 0xff : 0, nwords * sizeof(word_type));
+        nbits = n;
+        clear_unused_bits();
+    }
+
+    // 从 pos 所在的 word 开始查找第一个为 1 的位，word 中 pos 之前的位已经被屏蔽
+    size_type find_from(size_type index, word_type w) const {
+        const size_type used = words_for(nbits);
+        while (0 == w) {
+            if (++index >= used) return npos;
+            w = words[index];
+        }
+        return index * _WORD_BIT + __builtin_ctzl(w);
+    }
+
+public:
+    iterator begin() { return iterator(words, 0); }
+    const_iterator begin() const { return const_iterator(words, 0); }
+    iterator end() { return begin() + nbits; }
+    const_iterator end() const { return begin() + nbits; }
+
+    size_type size() const { return nbits; }
+    size_type max_size() const { return size_type(-1); }
+    size_type capacity() const { return nwords * _WORD_BIT; }
+    bool empty() const { return 0 == nbits; }
+
+    reference operator[](size_type n) {
+        return reference(words + n / _WORD_BIT, _bit_word(1) << (n % _WORD_BIT));
+    }
+    const_reference operator[](size_type n) const {
+        return 0 != (words[n / _WORD_BIT] & (_bit_word(1) << (n % _WORD_BIT)));
+    }
+
+    reference front() { return *begin(); }
+    const_reference front() const { return *begin(); }
+    reference back() { return *(end() - 1); }
+    const_reference back() const { return *(end() - 1); }
+
+    // 底层的 word 数组，共 (size() + WORD_BIT - 1) / WORD_BIT 个
+    word_type * data() { return words; }
+    const word_type * data() const { return words; }
+
+    vector() : words(nullptr), nbits(0), nwords(0) { }
+    explicit vector(const allocator_type& a) : data_allocator(a), words(nullptr), nbits(0), nwords(0) { }
+    vector(size_type n, bool value, const allocator_type& a = allocator_type())
+        : data_allocator(a) { initialize(n, value); }
+    explicit vector(size_type n) { initialize(n, false); }
+    vector(const vector& x) : data_allocator(x.data_allocator) {
+        initialize(x.nbits, false);
+        if (nbits)
+            memcpy(words, x.words, words_for(nbits) * sizeof(word_type));
+    }
+    vector(vector&& x) noexcept
+        : data_allocator(x.data_allocator), words(x.words), nbits(x.nbits), nwords(x.nwords) {
+        x.words = nullptr;
+        x.nbits = x.nwords = 0;
+    }
+
+    vector& operator=(const vector& x) {
+        if (&x != this) {
+            if (x.nbits > capacity()) {
+                deallocate();
+                nwords = words_for(x.nbits);
+                words = data_allocator.allocate(nwords);
+            }
+            if (x.nbits)
+                memcpy(words, x.words, words_for(x.nbits) * sizeof(word_type));
+            size_type used = words_for(nbits), xused = words_for(x.nbits);
+            if (used > xused)
+                memset(words + xused, 0, (used - xused) * sizeof(word_type));
+            nbits = x.nbits;
+        }
+        return *this;
+    }
+
+    vector& operator=(vector&& x) {
+        if (&x != this) {
+            if (data_allocator == x.data_allocator) {
+                deallocate();
+                words = x.words;
+                nbits = x.nbits;
+                nwords = x.nwords;
+                x.words = nullptr;
+                x.nbits = x.nwords = 0;
+            }
+            else
+                *this = static_cast<const vector&>(x);
+        }
+        return *this;
+    }
+
+    ~vector() { deallocate(); }
+
+    void swap(vector& x) {
+        word_allocator a = data_allocator;
+        data_allocator = x.data_allocator;
+        x.data_allocator = a;
+        word_type * w = words; words = x.words; x.words = w;
+        size_type n = nbits; nbits = x.nbits; x.nbits = n;
+        n = nwords; nwords = x.nwords; x.nwords = n;
+    }
+
+    void reserve(size_type n) {
+        if (n > capacity()) reallocate_storage(words_for(n));
+    }
+
+    void shrink_to_fit() {
+        if (0 == nbits) {
+            deallocate();
+            words = nullptr;
+            nwords = 0;
+        }
+        else if (words_for(nbits) < nwords)
+            reallocate_storage(words_for(nbits));
+    }
+
+    void push_back(bool x) {
+        grow_to(nbits + 1);
+        ++nbits;
+        back() = x;
+    }
+
+    void pop_back() {
+        --nbits;
+        (*this)[nbits] = false;
+    }
+
+    // 新增的元素为 x
+    void resize(size_type new_size, bool x = false) {
+        if (new_size < nbits) {
+            // 不再使用的 word 和位清零，保持不变式
+            size_type old_used = words_for(nbits);
+            nbits = new_size;
+            clear_unused_bits();
+            size_type used = words_for(nbits);
+            if (old_used > used)
+                memset(words + used, 0, (old_used - used) * sizeof(word_type));
+        }
+        else if (new_size > nbits) {
+            grow_to(new_size);
+            size_type old_size = nbits;
+            nbits = new_size;
+            if (x) ministl::fill(begin() + old_size, end(), true);
+        }
+    }
+
+    void clear() { resize(0); }
+
+    iterator insert(iterator position, bool x) {
+        size_type n = position - begin();
+        insert(position, 1, x);
+        return begin() + n;
+    }
+
+    void insert(iterator position, size_type n, bool x) {
+        if (0 == n) return;
+        size_type index = position - begin();
+        size_type old_size = nbits;
+        grow_to(nbits + n);
+        nbits += n;
+        ministl::copy_backward(begin() + index, begin() + old_size, end());
+        ministl::fill(begin() + index, begin() + index + n, x);
+    }
+
+    iterator erase(iterator position) {
+        return erase(position, position + 1);
+    }
+
+    iterator erase(iterator first, iterator last) {
+        size_type index = first - begin();
+        ministl::copy(last, end(), first);
+        resize(nbits - (last - first));
+        return begin() + index;
+    }
+
+    // 值为 true 的元素个数
+    size_type count() const {
+        size_type result = 0;
+        const size_type used = words_for(nbits);
+        for (size_type i = 0; i < used; ++i)
+            result += __builtin_popcountl(words[i]);
+        return result;
+    }
+
+    // 第一个值为 true 的元素位置，不存在时返回 npos
+    size_type find_first() const {
+        if (0 == nbits) return npos;
+        return find_from(0, words[0]);
+    }
+
+    // pos 之后第一个值为 true 的元素位置，不存在时返回 npos
+    size_type find_next(size_type pos) const {
+        if (pos == npos || ++pos >= nbits) return npos;
+        const size_type index = pos / _WORD_BIT;
+        return find_from(index, words[index] & (~_bit_word(0) << (pos % _WORD_BIT)));
+    }
+
+    // 所有元素取反
+    vector& flip() {
+        const size_type used = words_for(nbits);
+        for (size_type i = 0; i < used; ++i)
+            words[i] = ~words[i];
+        clear_unused_bits();
+        return *this;
+    }
+
+    // 以下按位运算要求 x.size() == size()，x 可以是 *this 本身
+    // 每个 word 只读写同一个下标，编译器对重叠的检查之后照样向量化，不需要 __restrict__
+    vector& operator&=(const vector& x) {
+        word_type * w = words;
+        const word_type * xw = x.words;
+        const size_type used = words_for(nbits);
+        for (size_type i = 0; i < used; ++i)
+            w[i] &= xw[i];
+        return *this;
+    }
+
+    vector& operator|=(const vector& x) {
+        word_type * w = words;
+        const word_type * xw = x.words;
+        const size_type used = words_for(nbits);
+        for (size_type i = 0; i < used; ++i)
+            w[i] |= xw[i];
+        return *this;
+    }
+
+    vector& operator^=(const vector& x) {
+        word_type * w = words;
+        const word_type * xw = x.words;
+        const size_type used = words_for(nbits);
+        for (size_type i = 0; i < used; ++i)
+            w[i] ^= xw[i];
+        return *this;
+    }
+
+    // 按 word 比较，末尾未使用的位都是 0
+    bool equal(const vector& x) const {
+        return nbits == x.nbits
+            && (0 == nbits || 0 == memcmp(words, x.words, words_for(nbits) * sizeof(word_type)));
+    }
+};
+
+template <typename Alloc, typename Growth>
+const typename vector<bool, Alloc, Growth>::size_type vector<bool, Alloc, Growth>::npos;
+
+// 按 word 比较，比 vector 的逐个元素比较快
+template <typename Alloc, typename Growth>
+inline bool
+operator==(const vector<bool, Alloc, Growth>& lhs, const vector<bool, Alloc, Growth>& rhs) {
+    return lhs.equal(rhs);
+}
+
+typedef vector<bool> bit_vector;
+
+}
+
+#endif // MINISTL_BVECTOR_H
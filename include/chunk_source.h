@@ -0,0 +1,260 @@
+#ifndef MINISTL_CHUNK_SOURCE_H
+#define MINISTL_CHUNK_SOURCE_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <sys/mman.h>   // for mmap, madvise
+#include <unistd.h>     // for sysconf
+
+namespace ministl {
+
+/**
+ * 一级配置器和二级配置器的内存来源
+ * 一个 chunk source 需要提供以下静态成员：
+ * GRANULARITY                      二级配置器向它申请的 chunk 大小会上调至 GRANULARITY 的倍数
+ * ALIGNMENT                        allocate 返回的地址至少按 ALIGNMENT 对齐
+ * void * allocate(size_t n)        分配 n 个字节，失败时返回 nullptr
+ * void deallocate(void *p, size_t n)
+ * void * reallocate(void *p, size_t old_size, size_t new_size)
+ *                                  失败时返回 nullptr，原来的内存不变
+ * void purge(void *p, size_t n)    [p, p + n) 是完整的页，内容不再需要，可以交还给操作系统
+ * 所有函数都需要是线程安全的
+ */
+
+inline size_t _page_size() {
+    static const size_t size = (size_t) sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+// 将 n 上调至 align 的倍数，align 为 2 的幂
+inline size_t _align_up(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+inline void _purge_pages(void *p, size_t n) {
+#ifdef MADV_DONTNEED
+    madvise(p, n, MADV_DONTNEED);
+#endif
+}
+
+/**
+ * 使用 malloc 分配内存，也是默认的内存来源
+ */
+struct malloc_chunk_source {
+    static const size_t GRANULARITY = 1;
+    static const size_t ALIGNMENT = alignof(max_align_t);
+
+    static void * allocate(size_t n) { return malloc(n); }
+
+    static void deallocate(void *p, size_t) { free(p); }
+
+    static void * reallocate(void *p, size_t, size_t new_size) {
+        return realloc(p, new_size);
+    }
+
+    static void purge(void *p, size_t n) { _purge_pages(p, n); }
+};
+
+/**
+ * 使用匿名 mmap 分配内存
+ * 不小于 2MB 的请求上调至 2MB 的倍数，起始地址按 2MB 对齐，并使用 MADV_HUGEPAGE
+ * 建议内核使用透明大页，减少 TLB miss
+ * 二级配置器向它申请的 chunk 都是 2MB 的倍数，小于 2MB 的请求 (一级配置器的大区块) 只按页对齐
+ * 不做任何缓存：每次 allocate 都是一次 mmap，每次 deallocate 都是一次 munmap，
+ * 用于二级配置器大于 MAX_BYTES 的请求时，频繁分配的中等大小区块开销很大，见 pool_alloc_template
+ */
+struct mmap_chunk_source {
+    static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+    static const size_t GRANULARITY = HUGE_PAGE;
+    static const size_t ALIGNMENT = 4096;
+
+    // 实际映射的字节数
+    static size_t mapped_size(size_t n) {
+        return n < HUGE_PAGE ? _align_up(n, _page_size()) : _align_up(n, HUGE_PAGE);
+    }
+
+    static void * map(size_t n) {
+        void *p = mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return MAP_FAILED == p ? nullptr : p;
+    }
+
+    static void advise_huge(void *p, size_t n) {
+#ifdef MADV_HUGEPAGE
+        madvise(p, n, MADV_HUGEPAGE);
+#else
+        (void) p; (void) n;
+#endif
+    }
+
+    static void * allocate(size_t n) {
+        n = mapped_size(n);
+        if (n < HUGE_PAGE) return map(n);
+        // 多映射 2MB，再把首尾多余的部分 munmap 掉，得到 2MB 对齐的地址
+        char *raw = (char *) map(n + HUGE_PAGE);
+        if (nullptr == raw) return nullptr;
+        char *aligned = (char *) _align_up((size_t) raw, HUGE_PAGE);
+        if (aligned != raw) munmap(raw, aligned - raw);
+        munmap(aligned + n, raw + HUGE_PAGE - aligned);
+        advise_huge(aligned, n);
+        return aligned;
+    }
+
+    static void deallocate(void *p, size_t n) {
+        munmap(p, mapped_size(n));
+    }
+
+    static void * reallocate(void *p, size_t old_size, size_t new_size) {
+        size_t old_mapped = mapped_size(old_size);
+        size_t new_mapped = mapped_size(new_size);
+        if (old_mapped == new_mapped) return p;
+#ifdef MREMAP_MAYMOVE
+        // 从小于 2MB 增长到 2MB 以上时 p 只按页对齐，mremap 得不到 2MB 对齐的地址，直接重新分配
+        if (new_mapped >= HUGE_PAGE && old_mapped < HUGE_PAGE)
+            return copy_reallocate(p, old_size, new_size);
+        // 由内核移动页表，不需要复制内容
+        void *result = mremap(p, old_mapped, new_mapped, MREMAP_MAYMOVE);
+        if (MAP_FAILED == result) return nullptr;
+        if (new_mapped < HUGE_PAGE) return result;
+        // 移动后的地址只保证按页对齐，不是 2MB 对齐时同样重新分配；
+        // 这时原区块已经不存在，重新分配失败只能返回按页对齐的 result
+        if (0 != ((size_t) result & (HUGE_PAGE - 1))) {
+            void *aligned = allocate(new_size);
+            if (nullptr != aligned) {
+                memcpy(aligned, result, old_size < new_size ? old_size : new_size);
+                deallocate(result, new_size);
+                return aligned;
+            }
+        }
+        advise_huge(result, new_mapped);
+        return result;
+#else
+        return copy_reallocate(p, old_size, new_size);
+#endif
+    }
+
+    // 分配 new_size 字节的新区块，复制内容后释放大小为 n 的区块 p
+    static void * copy_reallocate(void *p, size_t n, size_t new_size) {
+        void *result = allocate(new_size);
+        if (nullptr == result) return nullptr;
+        memcpy(result, p, n < new_size ? n : new_size);
+        deallocate(p, n);
+        return result;
+    }
+
+    static void purge(void *p, size_t n) { _purge_pages(p, n); }
+};
+
+/**
+ * 从一块预先保留的固定大小区域中分配内存
+ * 第一次使用时 mmap 保留 RegionBytes 字节的地址空间，之后所有内存都在这个区域中，地址可以预测
+ * 区域用完之后 allocate 返回 nullptr，交给配置器的 oom 处理
+ * 空闲的块按地址顺序串成链表，释放时与相邻的空闲块合并，分配时 first fit
+ * 所有操作由 region_lock 保护
+ */
+template <size_t RegionBytes>
+class region_chunk_source {
+public:
+    static const size_t GRANULARITY = 4096;
+    // 区域的起始地址按页对齐，每个块的大小和位置都是 sizeof(block) 的倍数
+    static const size_t ALIGNMENT = sizeof(void *) + sizeof(size_t);
+
+    static void * allocate(size_t n) {
+        n = block_size(n);
+        std::lock_guard<std::mutex> guard(region_lock);
+        if (nullptr == region && !reserve()) return nullptr;
+        block ** link = &free_blocks;
+        for (block * b = free_blocks; b; link = &b->next, b = b->next) {
+            if (b->bytes < n) continue;
+            if (b->bytes - n >= sizeof(block)) {
+                // 从空闲块的尾部切下 n 个字节，链表不需要调整
+                b->bytes -= n;
+                return (char *) b + b->bytes;
+            }
+            *link = b->next;
+            return b;
+        }
+        return nullptr;
+    }
+
+    static void deallocate(void *p, size_t n) {
+        n = block_size(n);
+        std::lock_guard<std::mutex> guard(region_lock);
+        block * b = (block *) p;
+        b->bytes = n;
+        // 找到按地址顺序插入的位置
+        block * prev = nullptr;
+        block * next = free_blocks;
+        while (next && next < b) {
+            prev = next;
+            next = next->next;
+        }
+        b->next = next;
+        if (next && (char *) b + b->bytes == (char *) next) {
+            b->bytes += next->bytes;
+            b->next = next->next;
+        }
+        if (prev && (char *) prev + prev->bytes == (char *) b) {
+            prev->bytes += b->bytes;
+            prev->next = b->next;
+        }
+        else if (prev) {
+            prev->next = b;
+        }
+        else {
+            free_blocks = b;
+        }
+    }
+
+    static void * reallocate(void *p, size_t old_size, size_t new_size) {
+        if (block_size(old_size) == block_size(new_size)) return p;
+        void *result = allocate(new_size);
+        if (nullptr == result) return nullptr;
+        memcpy(result, p, old_size < new_size ? old_size : new_size);
+        deallocate(p, old_size);
+        return result;
+    }
+
+    static void purge(void *p, size_t n) { _purge_pages(p, n); }
+
+    // 区域的起始地址，还没有使用过时为 nullptr
+    static char * base() { return region; }
+
+private:
+    struct block {
+        block * next;
+        size_t bytes;
+    };
+
+    static size_t block_size(size_t n) {
+        return _align_up(n < sizeof(block) ? sizeof(block) : n, sizeof(block));
+    }
+
+    static bool reserve() {
+        void *p = mmap(nullptr, RegionBytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (MAP_FAILED == p) return false;
+        region = (char *) p;
+        free_blocks = (block *) p;
+        free_blocks->next = nullptr;
+        free_blocks->bytes = RegionBytes;
+        return true;
+    }
+
+    static std::mutex region_lock;
+    static char * region;
+    static block * free_blocks;
+};
+
+template <size_t RegionBytes>
+std::mutex region_chunk_source<RegionBytes>::region_lock;
+template <size_t RegionBytes>
+char * region_chunk_source<RegionBytes>::region = nullptr;
+template <size_t RegionBytes>
+typename region_chunk_source<RegionBytes>::block *
+region_chunk_source<RegionBytes>::free_blocks = nullptr;
+
+}
+
+#endif // MINISTL_CHUNK_SOURCE_H
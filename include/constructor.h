@@ -6,23 +6,20 @@
 #include <new> // for placement new
 #include "iterator.h"
 #include "type_traits.h"
+#include "util.h"       // for forward
 
 namespace ministl {
 
-// 用于构造对象
-template <typename T1, typename T2>
-inline void construct(T1* p, const T2& value) {
+// 用于构造对象，参数原样转发给 T 的构造函数
+template <typename T, typename ... Args>
+inline void construct(T* p, Args&& ... args) {
     /**
      * 形如 new(p) A(value)
      * 这个 new 在 #include <new.h> 中，叫做 placement new
-     * 不会分配内存，会在已分配的内存地址 p 上执行 A 的构造函数，value为构造函数的参数 
+     * 不会分配内存，会在已分配的内存地址 p 上执行 A 的构造函数，args 为构造函数的参数 
+     * 没有参数时为 new(p) A()
      */
-    new(p) T1(value);       // placement new
-}
-
-template <typename T1, typename T2>
-inline void construct(T1* p) {
-    new(p) T1();
+    new(p) T(ministl::forward<Args>(args)...);       // placement new
 }
 
 // 用于析构对象
@@ -31,12 +28,17 @@ inline void destroy(T* ptr) {
     ptr->~T();
 }
 
-// 用于析构对象，参数为迭代器
+// 如果元素的型别有 non-trivial destructor 
 template <typename ForwardIterator>
-inline void destroy(ForwardIterator first, ForwardIterator last) {
-    _destroy(first, last, value_type(first));
+inline void _destroy_aux(ForwardIterator first, ForwardIterator last, ministl::false_type) {
+    for ( ; first < last; ++first)
+        ministl::destroy(&*first);
 }
 
+// 如果元素的型别有 trivial destructor, 什么也不做
+template <typename ForwardIterator>
+inline void _destroy_aux(ForwardIterator first, ForwardIterator last, ministl::true_type) { }
+
 // 判断元素的型别是否有 trivial destructor
 template <typename ForwardIterator, typename T>
 inline void _destroy(ForwardIterator first, ForwardIterator last, T*) {
@@ -44,17 +46,12 @@ inline void _destroy(ForwardIterator first, ForwardIterator last, T*) {
     _destroy_aux(first, last, trivial_destructor());
 }
 
-// 如果元素的型别有 non-trivial destructor 
+// 用于析构对象，参数为迭代器
 template <typename ForwardIterator>
-inline void _destroy_aux(ForwardIterator first, ForwardIterator last, ministl::false_type) {
-    for ( ; first < last; ++first)
-        destroy(&*first);
+inline void destroy(ForwardIterator first, ForwardIterator last) {
+    _destroy(first, last, value_type(first));
 }
 
-// 如果元素的型别有 trivial destructor, 什么也不做
-template <typename ForwardIterator>
-inline void _destroy_aux(ForwardIterator first, ForwardIterator last, ministl::true_type) { }
-
 // 基础类型的特化版本
 inline void _destroy(char*, char*) {}
 inline void _destroy(int*, int*) {}
@@ -0,0 +1,754 @@
+#ifndef MINISTL_DEQUE_H
+#define MINISTL_DEQUE_H
+
+#include <cstddef>
+#include <type_traits>      // for enable_if, is_same
+#include "allocator.h"
+#include "iterator.h"
+#include "uninitialized.h"
+#include "algo.h"
+
+namespace ministl {
+
+/**
+ * 双端队列，由多段定长的缓冲区 (node) 组成
+ * map 是一个指针数组，每个元素指向一个缓冲区，map 的中间部分正在使用，两端预留给增长
+ * 两端插入和删除都是 O(1)，只需要在两端分配或释放缓冲区，已有的元素永远不会被移动，
+ * 所以在两端 push / pop 时指向其他元素的引用和指针不会失效
+ * map 用满时重新分配 map (只复制指针)，迭代器失效但元素不动
+ *
+ * 缓冲区大小：
+ * BufSiz 不为 0 时每个缓冲区存放 BufSiz 个元素
+ * 否则每个缓冲区至多 512 字节，并且不超过 Alloc 的内存池能提供的最大区块 (元素更大时每个缓冲区一个元素)
+ * 这样每个缓冲区都是内存池中的一个区块，同一个 size class 的区块在 deque 之间反复复用
+ * 默认的 Alloc 使用 geometric_alloc_template，4096 字节以内都由内存池分配，缓冲区为 512 字节；
+ * 使用 default_alloc_template (MAX_BYTES 为 128) 时缓冲区缩小为 128 字节
+ */
+
+inline size_t _deque_buf_size(size_t n, size_t sz) {
+    return n != 0 ? n : (sz < 512 ? size_t(512 / sz) : size_t(1));
+}
+
+// 配置器 A 的内存池能直接提供的最大区块 (字节)，不是内存池的配置器时为 0
+template <typename A>
+struct _pool_max_bytes {
+    static const size_t value = 0;
+};
+
+template <typename T, typename SizeClass, typename ChunkSource>
+struct _pool_max_bytes<allocator<T, pool_alloc_template<SizeClass, ChunkSource> > > {
+    static const size_t value = SizeClass::MAX_BYTES;
+};
+
+// 每个缓冲区的元素个数
+template <typename T, typename Alloc, size_t BufSiz>
+struct _deque_node_elems {
+    static const size_t pool_max = _pool_max_bytes<Alloc>::value;
+    static const size_t bytes = 0 != pool_max && pool_max < 512 ? pool_max : 512;
+    static const size_t value = BufSiz != 0 ? BufSiz : (sizeof(T) < bytes ? bytes / sizeof(T) : 1);
+};
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz>
+struct _deque_iterator {
+    typedef _deque_iterator<T, T&, T*, BufSiz>              iterator;
+    typedef _deque_iterator<T, const T&, const T*, BufSiz>  const_iterator;
+    static size_t buffer_size() { return _deque_buf_size(BufSiz, sizeof(T)); }
+
+    typedef random_access_iterator_tag  iterator_category;
+    typedef T                           value_type;
+    typedef Ptr                         pointer;
+    typedef Ref                         reference;
+    typedef size_t                      size_type;
+    typedef ptrdiff_t                   difference_type;
+    typedef T**                         map_pointer;
+    typedef _deque_iterator             self;
+
+    T* cur;             // 当前元素
+    T* first;           // 当前缓冲区的头
+    T* last;            // 当前缓冲区的尾 (不含)
+    map_pointer node;   // 当前缓冲区在 map 中的位置
+
+    _deque_iterator(T* x, map_pointer y)
+        : cur(x), first(*y), last(*y + buffer_size()), node(y) { }
+    _deque_iterator() : cur(nullptr), first(nullptr), last(nullptr), node(nullptr) { }
+    // iterator 转换为 const_iterator
+    // 写成模板并排除同类型，复制构造和复制赋值仍由编译器隐式生成
+    template <typename R, typename P,
+              typename = typename std::enable_if<std::is_same<_deque_iterator<T, R, P, BufSiz>, iterator>::value
+                                                 && !std::is_same<R, Ref>::value>::type>
+    _deque_iterator(const _deque_iterator<T, R, P, BufSiz>& x)
+        : cur(x.cur), first(x.first), last(x.last), node(x.node) { }
+
+    reference operator*() const { return *cur; }
+    pointer operator->() const { return &(operator*()); }
+
+    difference_type operator-(const self& x) const {
+        return difference_type(buffer_size()) * (node - x.node - 1)
+             + (cur - first) + (x.last - x.cur);
+    }
+
+    // 跳到另一个缓冲区，cur 由调用者设置
+    void set_node(map_pointer new_node) {
+        node = new_node;
+        first = *new_node;
+        last = first + difference_type(buffer_size());
+    }
+
+    self& operator++() {
+        ++cur;
+        if (cur == last) {
+            set_node(node + 1);
+            cur = first;
+        }
+        return *this;
+    }
+    self operator++(int) {
+        self tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    self& operator--() {
+        if (cur == first) {
+            set_node(node - 1);
+            cur = last;
+        }
+        --cur;
+        return *this;
+    }
+    self operator--(int) {
+        self tmp = *this;
+        --*this;
+        return tmp;
+    }
+
+    self& operator+=(difference_type n) {
+        difference_type offset = n + (cur - first);
+        if (offset >= 0 && offset < difference_type(buffer_size()))
+            cur += n;       // 目标在同一个缓冲区内
+        else {
+            difference_type node_offset = offset > 0
+                ? offset / difference_type(buffer_size())
+                : -difference_type((-offset - 1) / buffer_size()) - 1;
+            set_node(node + node_offset);
+            cur = first + (offset - node_offset * difference_type(buffer_size()));
+        }
+        return *this;
+    }
+
+    self operator+(difference_type n) const {
+        self tmp = *this;
+        return tmp += n;
+    }
+
+    self& operator-=(difference_type n) { return *this += -n; }
+
+    self operator-(difference_type n) const {
+        self tmp = *this;
+        return tmp -= n;
+    }
+
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    bool operator==(const self& x) const { return cur == x.cur; }
+    bool operator!=(const self& x) const { return !(*this == x); }
+    bool operator<(const self& x) const {
+        return (node == x.node) ? (cur < x.cur) : (node < x.node);
+    }
+    bool operator>(const self& x) const { return x < *this; }
+    bool operator<=(const self& x) const { return !(x < *this); }
+    bool operator>=(const self& x) const { return !(*this < x); }
+};
+
+template <typename T, typename Alloc = ministl::allocator<T, geometric_alloc_template>, size_t BufSiz = 0>
+class deque {
+    static const size_t NODE_ELEMS = _deque_node_elems<T, Alloc, BufSiz>::value;
+
+public:
+    typedef T                   value_type;
+    typedef value_type*         pointer;
+    typedef const value_type*   const_pointer;
+    typedef value_type&         reference;
+    typedef const value_type&   const_reference;
+    typedef size_t              size_type;
+    typedef ptrdiff_t           difference_type;
+    typedef Alloc               allocator_type;
+    typedef _deque_iterator<T, T&, T*, NODE_ELEMS>              iterator;
+    typedef _deque_iterator<T, const T&, const T*, NODE_ELEMS>  const_iterator;
+    allocator_type get_allocator() const { return data_allocator; }
+
+protected:
+    typedef pointer* map_pointer;
+    typedef typename Alloc::template rebind<pointer>::other map_allocator_type;
+
+    enum { INITIAL_MAP_SIZE = 8 };
+
+    allocator_type      data_allocator;
+    map_allocator_type  map_allocator;
+    iterator            start;      // 第一个元素
+    iterator            finish;     // 最后一个元素之后，finish.cur 总是在一个已分配的缓冲区中
+    map_pointer         map;
+    size_type           map_size;   // map 中指针的个数
+
+    static size_type buffer_size() { return NODE_ELEMS; }
+
+    pointer allocate_node() { return data_allocator.allocate(buffer_size()); }
+    void deallocate_node(pointer p) { data_allocator.deallocate(p, buffer_size()); }
+
+    // 分配 map 和容纳 num_elements 个元素的缓冲区，元素未构造
+    void create_map_and_nodes(size_type num_elements);
+    // 析构之后释放所有缓冲区和 map
+    void destroy_map_and_nodes();
+
+    void fill_initialize(size_type n, const T& value);
+
+    // map 尾端 (头端) 至少还能放下 nodes_to_add 个缓冲区
+    void reserve_map_at_back(size_type nodes_to_add = 1) {
+        if (nodes_to_add + 1 > map_size - (finish.node - map))
+            reallocate_map(nodes_to_add, false);
+    }
+    void reserve_map_at_front(size_type nodes_to_add = 1) {
+        if (nodes_to_add > size_type(start.node - map))
+            reallocate_map(nodes_to_add, true);
+    }
+    void reallocate_map(size_type nodes_to_add, bool add_at_front);
+
+    // 在头端 (尾端) 预留 n 个未构造的位置，返回新的 start (finish)
+    iterator reserve_elements_at_front(size_type n) {
+        size_type vacancies = start.cur - start.first;
+        if (n > vacancies)
+            new_elements_at_front(n - vacancies);
+        return start - difference_type(n);
+    }
+    iterator reserve_elements_at_back(size_type n) {
+        size_type vacancies = (finish.last - finish.cur) - 1;
+        if (n > vacancies)
+            new_elements_at_back(n - vacancies);
+        return finish + difference_type(n);
+    }
+    void new_elements_at_front(size_type new_elements);
+    void new_elements_at_back(size_type new_elements);
+
+    // 释放预留位置用到的缓冲区
+    void destroy_nodes_at_front(iterator new_start) {
+        for (map_pointer n = new_start.node; n < start.node; ++n)
+            deallocate_node(*n);
+    }
+    void destroy_nodes_at_back(iterator new_finish) {
+        for (map_pointer n = new_finish.node; n > finish.node; --n)
+            deallocate_node(*n);
+    }
+
+    // 最后一个 (第一个) 缓冲区已满时的 push
+    template <typename ... Args>
+    void push_back_aux(Args&& ... args);
+    template <typename ... Args>
+    void push_front_aux(Args&& ... args);
+
+    template <typename ... Args>
+    iterator insert_aux(iterator position, Args&& ... args);
+
+public:
+    iterator begin() { return start; }
+    const_iterator begin() const { return start; }
+    iterator end() { return finish; }
+    const_iterator end() const { return finish; }
+
+    reference operator[](size_type n) { return start[difference_type(n)]; }
+    const_reference operator[](size_type n) const { return start[difference_type(n)]; }
+
+    reference front() { return *start; }
+    const_reference front() const { return *start; }
+    reference back() {
+        iterator tmp = finish;
+        --tmp;
+        return *tmp;
+    }
+    const_reference back() const {
+        const_iterator tmp = finish;
+        --tmp;
+        return *tmp;
+    }
+
+    size_type size() const { return finish - start; }
+    size_type max_size() const { return size_type(-1) / sizeof(T); }
+    bool empty() const { return finish == start; }
+
+    deque() : map(nullptr), map_size(0) { create_map_and_nodes(0); }
+    explicit deque(const allocator_type& a)
+        : data_allocator(a), map_allocator(a), map(nullptr), map_size(0) {
+        create_map_and_nodes(0);
+    }
+    deque(size_type n, const T& value, const allocator_type& a = allocator_type())
+        : data_allocator(a), map_allocator(a), map(nullptr), map_size(0) {
+        fill_initialize(n, value);
+    }
+    explicit deque(size_type n) : map(nullptr), map_size(0) { fill_initialize(n, T()); }
+    deque(const deque& x)
+        : data_allocator(x.data_allocator), map_allocator(x.map_allocator),
+          map(nullptr), map_size(0) {
+        create_map_and_nodes(x.size());
+        try {
+            ministl::uninitialized_copy(x.begin(), x.end(), start);
+        }
+        catch (...) {
+            destroy_map_and_nodes();
+            throw;
+        }
+    }
+    // 需要为 x 留下一个可用的空 map，所以不是 noexcept
+    deque(deque&& x)
+        : data_allocator(x.data_allocator), map_allocator(x.map_allocator),
+          map(nullptr), map_size(0) {
+        create_map_and_nodes(0);
+        swap(x);
+    }
+
+    ~deque() {
+        ministl::destroy(start, finish);
+        destroy_map_and_nodes();
+    }
+
+    deque& operator=(const deque& x);
+    deque& operator=(deque&& x);
+
+    void swap(deque& x) {
+        allocator_type a = data_allocator;
+        data_allocator = x.data_allocator;
+        x.data_allocator = a;
+        map_allocator_type ma = map_allocator;
+        map_allocator = x.map_allocator;
+        x.map_allocator = ma;
+        iterator it = start; start = x.start; x.start = it;
+        it = finish; finish = x.finish; x.finish = it;
+        map_pointer m = map; map = x.map; x.map = m;
+        size_type n = map_size; map_size = x.map_size; x.map_size = n;
+    }
+
+    void push_back(const T& x) { emplace_back(x); }
+    void push_back(T&& x) { emplace_back(ministl::move(x)); }
+    void push_front(const T& x) { emplace_front(x); }
+    void push_front(T&& x) { emplace_front(ministl::move(x)); }
+
+    template <typename ... Args>
+    void emplace_back(Args&& ... args) {
+        if (finish.cur != finish.last - 1) {
+            ministl::construct(finish.cur, ministl::forward<Args>(args)...);
+            ++finish.cur;
+        }
+        else
+            push_back_aux(ministl::forward<Args>(args)...);
+    }
+
+    template <typename ... Args>
+    void emplace_front(Args&& ... args) {
+        if (start.cur != start.first) {
+            ministl::construct(start.cur - 1, ministl::forward<Args>(args)...);
+            --start.cur;
+        }
+        else
+            push_front_aux(ministl::forward<Args>(args)...);
+    }
+
+    void pop_back() {
+        if (finish.cur != finish.first) {
+            --finish.cur;
+            ministl::destroy(finish.cur);
+        }
+        else {
+            // 最后一个缓冲区为空，释放它
+            deallocate_node(finish.first);
+            finish.set_node(finish.node - 1);
+            finish.cur = finish.last - 1;
+            ministl::destroy(finish.cur);
+        }
+    }
+
+    void pop_front() {
+        ministl::destroy(start.cur);
+        if (start.cur != start.last - 1)
+            ++start.cur;
+        else {
+            // 第一个缓冲区已经没有元素，释放它
+            deallocate_node(start.first);
+            start.set_node(start.node + 1);
+            start.cur = start.first;
+        }
+    }
+
+    // 析构所有元素，只保留一个缓冲区
+    void clear();
+
+    iterator erase(iterator position);
+    iterator erase(iterator first, iterator last);
+
+    template <typename ... Args>
+    iterator emplace(iterator position, Args&& ... args) {
+        if (position.cur == start.cur) {
+            emplace_front(ministl::forward<Args>(args)...);
+            return start;
+        }
+        else if (position.cur == finish.cur) {
+            emplace_back(ministl::forward<Args>(args)...);
+            iterator tmp = finish;
+            --tmp;
+            return tmp;
+        }
+        else
+            return insert_aux(position, ministl::forward<Args>(args)...);
+    }
+
+    iterator insert(iterator position, const T& x) {
+        return emplace(position, x);
+    }
+
+    iterator insert(iterator position, T&& x) {
+        return emplace(position, ministl::move(x));
+    }
+
+    void insert(iterator position, size_type n, const T& x);
+
+    void resize(size_type new_size, const T& x) {
+        const size_type len = size();
+        if (new_size < len)
+            erase(start + difference_type(new_size), finish);
+        else
+            insert(finish, new_size - len, x);
+    }
+    void resize(size_type new_size) { resize(new_size, T()); }
+};
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::create_map_and_nodes(size_type num_elements) {
+    // 需要的缓冲区个数，刚好整除时多分配一个，finish.cur 总是指向已分配的缓冲区
+    size_type num_nodes = num_elements / buffer_size() + 1;
+    // map 前后各至少预留一个位置
+    map_size = ministl::max(size_type(INITIAL_MAP_SIZE), num_nodes + 2);
+    map = map_allocator.allocate(map_size);
+
+    // 使用 map 中间的部分，两端的增长空间一样大
+    map_pointer nstart = map + (map_size - num_nodes) / 2;
+    map_pointer nfinish = nstart + num_nodes - 1;
+    map_pointer cur = nstart;
+    try {
+        for ( ; cur <= nfinish; ++cur)
+            *cur = allocate_node();
+    }
+    catch (...) {
+        for (map_pointer n = nstart; n < cur; ++n)
+            deallocate_node(*n);
+        map_allocator.deallocate(map, map_size);
+        map = nullptr;
+        map_size = 0;
+        throw;
+    }
+    start.set_node(nstart);
+    finish.set_node(nfinish);
+    start.cur = start.first;
+    finish.cur = finish.first + num_elements % buffer_size();
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::destroy_map_and_nodes() {
+    if (nullptr == map) return;
+    for (map_pointer n = start.node; n <= finish.node; ++n)
+        deallocate_node(*n);
+    map_allocator.deallocate(map, map_size);
+    map = nullptr;
+    map_size = 0;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::fill_initialize(size_type n, const T& value) {
+    create_map_and_nodes(n);
+    try {
+        ministl::uninitialized_fill(start, finish, value);
+    }
+    catch (...) {
+        destroy_map_and_nodes();
+        throw;
+    }
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::reallocate_map(size_type nodes_to_add, bool add_at_front) {
+    size_type old_num_nodes = finish.node - start.node + 1;
+    size_type new_num_nodes = old_num_nodes + nodes_to_add;
+
+    map_pointer new_nstart;
+    if (map_size > 2 * new_num_nodes) {
+        // map 还有足够的空间，只是一端用完了，把使用的部分移到中间
+        new_nstart = map + (map_size - new_num_nodes) / 2
+                   + (add_at_front ? nodes_to_add : 0);
+        if (new_nstart < start.node)
+            ministl::copy(start.node, finish.node + 1, new_nstart);
+        else
+            ministl::copy_backward(start.node, finish.node + 1, new_nstart + old_num_nodes);
+    }
+    else {
+        size_type new_map_size = map_size + ministl::max(map_size, nodes_to_add) + 2;
+        map_pointer new_map = map_allocator.allocate(new_map_size);
+        new_nstart = new_map + (new_map_size - new_num_nodes) / 2
+                   + (add_at_front ? nodes_to_add : 0);
+        ministl::copy(start.node, finish.node + 1, new_nstart);
+        map_allocator.deallocate(map, map_size);
+        map = new_map;
+        map_size = new_map_size;
+    }
+
+    // 只有指针被复制，cur 在缓冲区中的位置不变
+    start.set_node(new_nstart);
+    finish.set_node(new_nstart + old_num_nodes - 1);
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::new_elements_at_front(size_type new_elements) {
+    size_type new_nodes = (new_elements + buffer_size() - 1) / buffer_size();
+    reserve_map_at_front(new_nodes);
+    size_type i;
+    try {
+        for (i = 1; i <= new_nodes; ++i)
+            *(start.node - i) = allocate_node();
+    }
+    catch (...) {
+        for (size_type j = 1; j < i; ++j)
+            deallocate_node(*(start.node - j));
+        throw;
+    }
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::new_elements_at_back(size_type new_elements) {
+    size_type new_nodes = (new_elements + buffer_size() - 1) / buffer_size();
+    reserve_map_at_back(new_nodes);
+    size_type i;
+    try {
+        for (i = 1; i <= new_nodes; ++i)
+            *(finish.node + i) = allocate_node();
+    }
+    catch (...) {
+        for (size_type j = 1; j < i; ++j)
+            deallocate_node(*(finish.node + j));
+        throw;
+    }
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+template <typename ... Args>
+void deque<T, Alloc, BufSiz>::push_back_aux(Args&& ... args) {
+    reserve_map_at_back();
+    *(finish.node + 1) = allocate_node();
+    try {
+        ministl::construct(finish.cur, ministl::forward<Args>(args)...);
+    }
+    catch (...) {
+        deallocate_node(*(finish.node + 1));
+        throw;
+    }
+    finish.set_node(finish.node + 1);
+    finish.cur = finish.first;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+template <typename ... Args>
+void deque<T, Alloc, BufSiz>::push_front_aux(Args&& ... args) {
+    reserve_map_at_front();
+    *(start.node - 1) = allocate_node();
+    try {
+        ministl::construct(*(start.node - 1) + (buffer_size() - 1),
+                           ministl::forward<Args>(args)...);
+    }
+    catch (...) {
+        deallocate_node(*(start.node - 1));
+        throw;
+    }
+    start.set_node(start.node - 1);
+    start.cur = start.last - 1;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::clear() {
+    // 中间的缓冲区都是满的
+    for (map_pointer node = start.node + 1; node < finish.node; ++node) {
+        ministl::destroy(*node, *node + buffer_size());
+        deallocate_node(*node);
+    }
+    if (start.node != finish.node) {
+        ministl::destroy(start.cur, start.last);
+        ministl::destroy(finish.first, finish.cur);
+        // 保留第一个缓冲区
+        deallocate_node(finish.first);
+    }
+    else
+        ministl::destroy(start.cur, finish.cur);
+    finish = start;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+typename deque<T, Alloc, BufSiz>::iterator
+deque<T, Alloc, BufSiz>::erase(iterator position) {
+    iterator next = position;
+    ++next;
+    difference_type index = position - start;
+    // 移动较少的一端
+    if (size_type(index) < (size() >> 1)) {
+        ministl::move_backward(start, position, next);
+        pop_front();
+    }
+    else {
+        ministl::move(next, finish, position);
+        pop_back();
+    }
+    return start + index;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+typename deque<T, Alloc, BufSiz>::iterator
+deque<T, Alloc, BufSiz>::erase(iterator first, iterator last) {
+    if (first == start && last == finish) {
+        clear();
+        return finish;
+    }
+    difference_type n = last - first;
+    // 空区间时 move 会把元素移动赋值给自己，std::string 等类型会被清空
+    if (0 == n) return first;
+    difference_type elems_before = first - start;
+    if (elems_before < difference_type(size() - n) / 2) {
+        // 前面的元素较少，向后移动前面的元素
+        ministl::move_backward(start, first, last);
+        iterator new_start = start + n;
+        ministl::destroy(start, new_start);
+        for (map_pointer node = start.node; node < new_start.node; ++node)
+            deallocate_node(*node);
+        start = new_start;
+    }
+    else {
+        // 后面的元素较少，向前移动后面的元素
+        ministl::move(last, finish, first);
+        iterator new_finish = finish - n;
+        ministl::destroy(new_finish, finish);
+        for (map_pointer node = new_finish.node + 1; node <= finish.node; ++node)
+            deallocate_node(*node);
+        finish = new_finish;
+    }
+    return start + elems_before;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+template <typename ... Args>
+typename deque<T, Alloc, BufSiz>::iterator
+deque<T, Alloc, BufSiz>::insert_aux(iterator position, Args&& ... args) {
+    // 先构造新元素，args 可能引用将要被移动的元素
+    T x_copy(ministl::forward<Args>(args)...);
+    difference_type index = position - start;
+    if (size_type(index) < size() / 2) {
+        // 插入点之前的元素较少，在头端加入一个元素，前面的元素向前移动一格
+        emplace_front(ministl::move(front()));
+        iterator front1 = start;
+        ++front1;
+        iterator front2 = front1;
+        ++front2;
+        position = start + index;
+        iterator pos1 = position;
+        ++pos1;
+        ministl::move(front2, pos1, front1);
+    }
+    else {
+        // 插入点之后的元素较少，在尾端加入一个元素，后面的元素向后移动一格
+        emplace_back(ministl::move(back()));
+        iterator back1 = finish;
+        --back1;
+        iterator back2 = back1;
+        --back2;
+        position = start + index;
+        ministl::move_backward(position, back2, back1);
+    }
+    *position = ministl::move(x_copy);
+    return position;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+void deque<T, Alloc, BufSiz>::insert(iterator position, size_type n, const T& x) {
+    if (0 == n) return;
+    // x 可能引用将要被移动的元素，先复制一份
+    T x_copy = x;
+    if (position.cur == start.cur) {
+        iterator new_start = reserve_elements_at_front(n);
+        try {
+            ministl::uninitialized_fill(new_start, start, x_copy);
+        }
+        catch (...) {
+            destroy_nodes_at_front(new_start);
+            throw;
+        }
+        start = new_start;
+    }
+    else if (position.cur == finish.cur) {
+        iterator new_finish = reserve_elements_at_back(n);
+        try {
+            ministl::uninitialized_fill(finish, new_finish, x_copy);
+        }
+        catch (...) {
+            destroy_nodes_at_back(new_finish);
+            throw;
+        }
+        finish = new_finish;
+    }
+    else {
+        const difference_type index = position - start;
+        const difference_type elems_after = difference_type(size()) - index;
+        if (index < elems_after) {
+            // 在头端加入 n 个元素，再把插入点之前的元素向前移动 n 格
+            insert(start, n, x_copy);
+            iterator old_start = start + difference_type(n);
+            ministl::move(old_start, old_start + index, start);
+            ministl::fill(start + index, old_start + index, x_copy);
+        }
+        else {
+            // 在尾端加入 n 个元素，再把插入点之后的元素向后移动 n 格
+            insert(finish, n, x_copy);
+            iterator old_finish = finish - difference_type(n);
+            iterator pos = old_finish - elems_after;
+            ministl::move_backward(pos, old_finish, finish);
+            ministl::fill(pos, pos + difference_type(n), x_copy);
+        }
+    }
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+deque<T, Alloc, BufSiz>&
+deque<T, Alloc, BufSiz>::operator=(const deque& x) {
+    if (&x != this) {
+        const size_type len = size();
+        if (len >= x.size())
+            erase(ministl::copy(x.begin(), x.end(), start), finish);
+        else {
+            const_iterator mid = x.begin() + difference_type(len);
+            ministl::copy(x.begin(), mid, start);
+            for ( ; mid != x.end(); ++mid)
+                push_back(*mid);
+        }
+    }
+    return *this;
+}
+
+template <typename T, typename Alloc, size_t BufSiz>
+deque<T, Alloc, BufSiz>&
+deque<T, Alloc, BufSiz>::operator=(deque&& x) {
+    if (&x != this) {
+        clear();
+        if (data_allocator == x.data_allocator)
+            swap(x);
+        else {
+            // 两个配置器的内存不能互相归还，只能逐个移动元素
+            for (iterator it = x.begin(); it != x.end(); ++it)
+                push_back(ministl::move(*it));
+            x.clear();
+        }
+    }
+    return *this;
+}
+
+}
+
+#endif // MINISTL_DEQUE_H
@@ -0,0 +1,63 @@
+#ifndef MINISTL_GROWTH_POLICY_H
+#define MINISTL_GROWTH_POLICY_H
+
+#include <stddef.h>
+#include "allocator.h"
+#include "chunk_source.h"   // for _align_up
+
+namespace ministl {
+
+/**
+ * vector 的增长策略，作为 vector 的第三个模板参数
+ * 空间不足时调用 Growth::next_capacity<A>(capacity, required, elem_size) 得到新的容量 (元素个数)
+ *     capacity     当前容量
+ *     required     至少需要容纳的元素个数
+ *     elem_size    sizeof(T)
+ *     A            vector 的配置器，用于查询 good_size
+ * 返回值不能小于 required
+ */
+
+// 容量翻倍，SGI STL 的做法
+struct double_growth {
+    template <typename A>
+    static size_t next_capacity(size_t capacity, size_t required, size_t) {
+        size_t len = capacity * 2;
+        return len < required ? required : len;
+    }
+};
+
+// 容量增长 1.5 倍
+// 翻倍时新区块总是大于之前释放的所有区块之和，1.5 倍时之前释放的区块有机会合并后被复用
+struct half_growth {
+    template <typename A>
+    static size_t next_capacity(size_t capacity, size_t required, size_t) {
+        size_t len = capacity + capacity / 2;
+        return len < required ? required : len;
+    }
+};
+
+// 在 Base 的基础上向上取整到配置器的 size class，区块末尾原本浪费的空间也作为容量
+// 例如 default_alloc_template 按 8 字节分级，vector<char> 的容量总是 8 的倍数
+template <typename Base = double_growth>
+struct size_class_growth {
+    template <typename A>
+    static size_t next_capacity(size_t capacity, size_t required, size_t elem_size) {
+        return _good_capacity<A>(Base::template next_capacity<A>(capacity, required, elem_size));
+    }
+};
+
+// 在 Base 的基础上，不小于一页时向上取整到整页，小于一页时取整到 size class
+// 大区块由 mmap 或 malloc 按页分配，页内剩余的空间也作为容量
+template <typename Base = double_growth, size_t PageSize = 4096>
+struct page_growth {
+    template <typename A>
+    static size_t next_capacity(size_t capacity, size_t required, size_t elem_size) {
+        size_t n = Base::template next_capacity<A>(capacity, required, elem_size);
+        if (n * elem_size < PageSize) return _good_capacity<A>(n);
+        return _align_up(n * elem_size, PageSize) / elem_size;
+    }
+};
+
+}
+
+#endif // MINISTL_GROWTH_POLICY_H
@@ -0,0 +1,286 @@
+#ifndef MINISTL_HEAP_PROFILER_H
+#define MINISTL_HEAP_PROFILER_H
+
+/**
+ * 采样的堆分析器
+ * 定义 MINISTL_HEAP_PROFILER 后，allocator<T, Alloc> 的 allocate 和 deallocate 会通知分析器
+ * 没有定义时以下两个宏为空，allocator 中没有任何额外的代码
+ */
+#ifndef MINISTL_HEAP_PROFILER
+
+#define _MINISTL_PROFILE_ALLOCATE(T, Alloc, p, bytes)
+#define _MINISTL_PROFILE_DEALLOCATE(p)
+
+#else
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>    // for sort
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <typeinfo>
+#include <execinfo.h>   // for backtrace
+#if defined(__GNUC__)
+#include <cxxabi.h>     // for __cxa_demangle
+#endif
+
+#define _MINISTL_PROFILE_ALLOCATE(T, Alloc, p, bytes) \
+    ministl::heap_profiler::record_allocate<T, Alloc>(p, bytes)
+#define _MINISTL_PROFILE_DEALLOCATE(p) \
+    ministl::heap_profiler::record_deallocate(p)
+
+namespace ministl {
+
+// 定义在 allocator.h 中，Alloc 没有 good_size 时 size class 的大小记为申请的字节数
+template <typename A>
+inline size_t _good_capacity(size_t n);
+
+/**
+ * 每分配 sample_interval 字节 (平均) 采样一次，参考 tcmalloc 的做法
+ * 每个线程有一个字节倒计数，allocate 时减去申请的字节数，小于 0 时才进入采样的慢路径
+ * 两次采样之间的间隔服从指数分布，这样每个字节被采样的概率相同，不会和程序的分配模式同步
+ * 被采样的区块记录元素类型 T、申请的字节数、所在 size class 的大小 (Alloc::good_size，没有时为申请的字节数) 和调用栈
+ *
+ * deallocate 时用一个计数过滤器判断区块是否可能被采样过：
+ * 地址散列到 FILTER_SIZE 个原子计数之一，采样时加一，移除采样时减一
+ * 计数为 0 说明一定没有被采样，只需要一次 relaxed load；不为 0 时才加锁查表
+ *
+ * dump() 按 (类型, size class, 调用栈) 汇总当前还存活的采样
+ * 每个采样按 bytes / (1 - exp(-bytes / interval)) 放大，估计真实的存活字节数
+ */
+class heap_profiler {
+
+public:
+    static const int MAX_FRAMES = 32;
+
+    // 设置平均采样间隔 (字节)，0 表示停止采样，已经采样的区块仍然会被跟踪
+    static void set_sample_interval(size_t bytes) {
+        interval().store(bytes, std::memory_order_relaxed);
+    }
+
+    static size_t sample_interval() {
+        return interval().load(std::memory_order_relaxed);
+    }
+
+    template <typename T, typename Alloc>
+    static void record_allocate(void *p, size_t bytes) {
+        thread_sampler & s = sampler();
+        s.countdown -= (ptrdiff_t) bytes;
+        if (s.countdown < 0)
+            sample(p, bytes, _good_capacity<Alloc>(bytes), &typeid(T));
+    }
+
+    static void record_deallocate(void *p) {
+        if (0 != filter()[FILTER_INDEX(p)].load(std::memory_order_relaxed))
+            remove_sample(p);
+    }
+
+    // 当前存活的采样个数
+    static size_t live_samples() {
+        profile & prof = get_profile();
+        std::lock_guard<std::mutex> guard(prof.lock);
+        return prof.live.size();
+    }
+
+    // 输出存活堆的分析结果
+    static void dump(FILE *out);
+
+    static bool dump(const char *path) {
+        FILE *out = fopen(path, "w");
+        if (nullptr == out) return false;
+        dump(out);
+        fclose(out);
+        return true;
+    }
+
+private:
+    static const size_t FILTER_BITS = 12;
+    static const size_t FILTER_SIZE = (size_t) 1 << FILTER_BITS;
+
+    // 每个线程的采样状态，只有 trivial 的构造，线程第一次使用时全部为 0
+    struct thread_sampler {
+        ptrdiff_t countdown;    // 距离下一次采样还剩的字节数
+        uint64_t rng;           // xorshift 随机数状态
+        bool started;           // countdown 已经初始化
+    };
+
+    struct sample_record {
+        size_t bytes;
+        size_t class_bytes;
+        size_t interval;        // 采样时的平均间隔，用于放大
+        const std::type_info *type;
+        int depth;
+        void *stack[MAX_FRAMES];
+    };
+
+    // 存活的采样，使用 std 的容器和 malloc，避免递归进入 allocator
+    struct profile {
+        std::mutex lock;
+        std::unordered_map<void *, sample_record> live;
+    };
+
+    static std::atomic<size_t> & interval() {
+        static std::atomic<size_t> bytes(512 * 1024);
+        return bytes;
+    }
+
+    static thread_sampler & sampler() {
+        static thread_local thread_sampler s;
+        return s;
+    }
+
+    static std::atomic<uint32_t> * filter() {
+        static std::atomic<uint32_t> counts[FILTER_SIZE];
+        return counts;
+    }
+
+    // 永不析构，静态对象析构之后的 deallocate 仍然可以安全地查询
+    static profile & get_profile() {
+        static profile * prof = new profile;
+        return *prof;
+    }
+
+    static size_t FILTER_INDEX(void *p) {
+        return (size_t) (((uintptr_t) p >> 3) * 0x9E3779B97F4A7C15ULL >> (64 - FILTER_BITS));
+    }
+
+    // 下一次采样的间隔，服从均值为 mean 的指数分布
+    static ptrdiff_t next_countdown(thread_sampler & s, size_t mean) {
+        if (0 == s.rng) s.rng = (uint64_t) (uintptr_t) &s * 0x9E3779B97F4A7C15ULL | 1;
+        s.rng ^= s.rng << 13;
+        s.rng ^= s.rng >> 7;
+        s.rng ^= s.rng << 17;
+        // 取 53 位得到 (0, 1] 之间的均匀分布
+        double u = ((s.rng >> 11) + 1) * (1.0 / 9007199254740992.0);
+        double next = -log(u) * mean;
+        return next > (double) PTRDIFF_MAX / 2 ? PTRDIFF_MAX / 2 : (ptrdiff_t) next + 1;
+    }
+
+    // 采样的慢路径，不内联以免增加 allocate 快路径的代码
+    __attribute__((noinline))
+    static void sample(void *p, size_t bytes, size_t class_bytes, const std::type_info *type) {
+        thread_sampler & s = sampler();
+        size_t mean = sample_interval();
+        if (0 == mean) {
+            s.countdown = PTRDIFF_MAX / 2;
+            return;
+        }
+        // 线程第一次进入慢路径只初始化倒计数，不采样
+        bool started = s.started;
+        s.started = true;
+        s.countdown = next_countdown(s, mean);
+        if (!started || nullptr == p) return;
+
+        sample_record r;
+        r.bytes = bytes;
+        r.class_bytes = class_bytes;
+        r.interval = mean;
+        r.type = type;
+        // 跳过 sample 自己的栈帧
+        void *frames[MAX_FRAMES + 1];
+        int depth = backtrace(frames, MAX_FRAMES + 1);
+        r.depth = depth > 1 ? depth - 1 : 0;
+        memcpy(r.stack, frames + 1, r.depth * sizeof(void *));
+
+        profile & prof = get_profile();
+        std::lock_guard<std::mutex> guard(prof.lock);
+        if (prof.live.insert(std::make_pair(p, r)).second)
+            filter()[FILTER_INDEX(p)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    __attribute__((noinline))
+    static void remove_sample(void *p) {
+        profile & prof = get_profile();
+        std::lock_guard<std::mutex> guard(prof.lock);
+        if (prof.live.erase(p))
+            filter()[FILTER_INDEX(p)].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static std::string type_name(const std::type_info *type) {
+#if defined(__GNUC__)
+        int status = 0;
+        char *name = abi::__cxa_demangle(type->name(), nullptr, nullptr, &status);
+        if (0 == status && name) {
+            std::string result(name);
+            free(name);
+            return result;
+        }
+#endif
+        return type->name();
+    }
+};
+
+inline void heap_profiler::dump(FILE *out) {
+    // 汇总项，按 (类型, size class, 调用栈) 区分
+    struct bucket {
+        const std::type_info *type;
+        size_t class_bytes;
+        std::vector<void *> stack;
+        size_t samples;
+        double objects;
+        double bytes;
+    };
+    typedef std::pair<std::pair<std::string, size_t>, std::vector<void *> > bucket_key;
+    std::map<bucket_key, bucket> buckets;
+    size_t total_samples = 0;
+    double total_bytes = 0;
+    {
+        profile & prof = get_profile();
+        std::lock_guard<std::mutex> guard(prof.lock);
+        for (std::unordered_map<void *, sample_record>::const_iterator it = prof.live.begin();
+             it != prof.live.end(); ++it) {
+            const sample_record & r = it->second;
+            std::vector<void *> stack(r.stack, r.stack + r.depth);
+            bucket_key key(std::make_pair(std::string(r.type->name()), r.class_bytes), stack);
+            bucket & b = buckets[key];
+            if (0 == b.samples) {
+                b.type = r.type;
+                b.class_bytes = r.class_bytes;
+                b.stack = stack;
+                b.objects = b.bytes = 0;
+            }
+            // 大小为 bytes 的区块被采样的概率为 1 - exp(-bytes / interval)
+            double scale = 1.0 / (1.0 - exp(-(double) r.bytes / r.interval));
+            ++b.samples;
+            b.objects += scale;
+            b.bytes += scale * r.bytes;
+            ++total_samples;
+            total_bytes += scale * r.bytes;
+        }
+    }
+
+    // 按估计的字节数从大到小输出
+    std::vector<const bucket *> sorted;
+    for (std::map<bucket_key, bucket>::const_iterator it = buckets.begin();
+         it != buckets.end(); ++it)
+        sorted.push_back(&it->second);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const bucket *a, const bucket *b) { return a->bytes > b->bytes; });
+
+    fprintf(out, "heap profile: %zu samples, ~%.0f live bytes (sample interval %zu bytes)\n",
+            total_samples, total_bytes, sample_interval());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const bucket & b = *sorted[i];
+        fprintf(out, "\n~%.0f bytes in ~%.0f objects (%zu samples) of %s, size class %zu\n",
+                b.bytes, b.objects, b.samples, type_name(b.type).c_str(), b.class_bytes);
+        char **symbols = backtrace_symbols(b.stack.data(), (int) b.stack.size());
+        for (size_t k = 0; k < b.stack.size(); ++k)
+            fprintf(out, "    #%zu %s\n", k, symbols ? symbols[k] : "?");
+        free(symbols);
+    }
+    fflush(out);
+}
+
+}
+
+#endif // MINISTL_HEAP_PROFILER
+
+#endif // MINISTL_HEAP_PROFILER_H
@@ -0,0 +1,184 @@
+#ifndef MINISTL_INTERN_H
+#define MINISTL_INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>         // for memcpy, memcmp
+#include <functional>       // for std::hash
+#include <stdexcept>        // for length_error, out_of_range
+#include "arena.h"
+#include "string_view.h"
+#include "vector.h"
+
+namespace ministl {
+
+// 字符串池中的一项，字符紧跟在后面，以 '\0' 结尾
+struct _intern_entry {
+    size_t hash;
+    uint32_t size;
+    uint32_t id;
+
+    const char * data() const { return reinterpret_cast<const char *>(this + 1); }
+};
+
+/**
+ * intern_pool 返回的句柄，只有一个指针大小
+ * 同一个池中内容相同的字符串得到同一个句柄，相等比较只比较指针，hash() 直接返回保存的值
+ * 默认构造的句柄为空，表示没有找到
+ * 句柄和它引用的字符在池析构之前一直有效
+ */
+class interned_string {
+    friend class intern_pool;
+
+public:
+    interned_string() : entry(nullptr) { }
+
+    explicit operator bool() const { return nullptr != entry; }
+
+    size_t size() const { return entry ? entry->size : 0; }
+    bool empty() const { return 0 == size(); }
+    const char * data() const { return entry ? entry->data() : ""; }
+    const char * c_str() const { return data(); }
+    size_t hash() const { return entry ? entry->hash : 0; }
+
+    // 在池中的编号，从 0 开始连续分配，可以用 intern_pool::operator[] 换回句柄
+    // 空句柄返回 UINT32_MAX，不是任何字符串的编号，intern_pool::at 对它抛出 out_of_range
+    uint32_t id() const { return entry ? entry->id : UINT32_MAX; }
+
+    string_view view() const { return string_view(data(), size()); }
+    operator string_view() const { return view(); }
+
+    bool operator== (interned_string x) const { return entry == x.entry; }
+    bool operator!= (interned_string x) const { return entry != x.entry; }
+
+private:
+    const _intern_entry *entry;
+
+    explicit interned_string(const _intern_entry *p) : entry(p) { }
+};
+
+inline std::ostream& operator<< (std::ostream& os, interned_string s) {
+    return os.write(s.data(), s.size());
+}
+
+// FNV-1a
+inline size_t _intern_hash(const char *s, size_t n) {
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char) s[i];
+        h *= 1099511628211ULL;
+    }
+    return (size_t) h;
+}
+
+/**
+ * 字符串驻留 (interning) 池
+ * 每个不同的字符串只在池中保存一次：{ hash, 长度, 编号 } 加上字符，从 monotonic_arena 中连续分配
+ * 与每个字符串单独在堆上分配相比，没有重复的副本，也没有每个区块的头部和 size class 的浪费
+ * 查找表是开放定址 (线性探查) 的 hash 表，只保存指针，负载因子不超过 1/2
+ * 字符串一旦加入就不会删除，所有的内存在池析构时一次性归还
+ * 不是线程安全的
+ */
+class intern_pool {
+
+public:
+    explicit intern_pool(size_t initial_bytes = 64 * 1024)
+        : arena(initial_bytes), table(16, (const _intern_entry *) nullptr) { }
+
+    intern_pool(const intern_pool &) = delete;
+    intern_pool& operator= (const intern_pool &) = delete;
+
+    // 返回 s 对应的句柄，s 不在池中时先加入
+    interned_string intern(string_view s) {
+        size_t h = _intern_hash(s.data(), s.size());
+        size_t i = probe(s, h);
+        if (table[i]) return interned_string(table[i]);
+        if ((entries.size() + 1) * 2 > table.size()) {
+            rehash(table.size() * 2);
+            i = probe(s, h);
+        }
+        const _intern_entry *p = new_entry(s, h);
+        table[i] = p;
+        return interned_string(p);
+    }
+
+    // s 不在池中时返回空的句柄
+    interned_string find(string_view s) const {
+        return interned_string(table[probe(s, _intern_hash(s.data(), s.size()))]);
+    }
+
+    interned_string operator[](uint32_t id) const { return interned_string(entries[id]); }
+
+    interned_string at(uint32_t id) const {
+        if (id >= entries.size()) throw std::out_of_range("ministl::intern_pool");
+        return (*this)[id];
+    }
+
+    // 不同字符串的个数
+    size_t size() const { return entries.size(); }
+
+    // 池占用的字节数，包括字符、每项的头部和查找表
+    size_t bytes_used() const {
+        return arena.bytes_allocated() + (table.capacity() + entries.capacity()) * sizeof(const _intern_entry *);
+    }
+
+private:
+    monotonic_arena arena;
+    vector<const _intern_entry *> table;        // 大小是 2 的幂，空位为 nullptr
+    vector<const _intern_entry *> entries;      // 按编号
+
+    // s 所在的位置，或者应该插入 s 的空位
+    size_t probe(string_view s, size_t h) const {
+        size_t mask = table.size() - 1;
+        size_t i = h & mask;
+        while (const _intern_entry *p = table[i]) {
+            if (p->hash == h && p->size == s.size() && 0 == memcmp(p->data(), s.data(), s.size()))
+                return i;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void rehash(size_t n) {
+        vector<const _intern_entry *> t(n, (const _intern_entry *) nullptr);
+        size_t mask = n - 1;
+        for (size_t k = 0; k < entries.size(); ++k) {
+            size_t i = entries[k]->hash & mask;
+            while (t[i]) i = (i + 1) & mask;
+            t[i] = entries[k];
+        }
+        table.swap(t);
+    }
+
+    const _intern_entry * new_entry(string_view s, size_t h) {
+        if (s.size() > UINT32_MAX || entries.size() >= UINT32_MAX)
+            throw std::length_error("ministl::intern_pool");
+        // 先保证 entries 有空位，之后的 push_back 不会失败，arena 中不会留下没有登记的项
+        // 按倍数扩容，每次只加一个会让每个新字符串都复制整个 entries
+        if (entries.size() == entries.capacity())
+            entries.reserve(entries.size() ? entries.size() * 2 : 16);
+        _intern_entry *p = (_intern_entry *) arena.allocate(sizeof(_intern_entry) + s.size() + 1,
+                                                            alignof(_intern_entry));
+        p->hash = h;
+        p->size = (uint32_t) s.size();
+        p->id = (uint32_t) entries.size();
+        memcpy(const_cast<char *>(p->data()), s.data(), s.size());
+        const_cast<char *>(p->data())[s.size()] = '\0';
+        entries.push_back(p);
+        return p;
+    }
+};
+
+}
+
+namespace std {
+
+// 可以直接作为 unordered_map 等容器的键
+template <>
+struct hash<ministl::interned_string> {
+    size_t operator()(ministl::interned_string s) const { return s.hash(); }
+};
+
+}
+
+#endif // MINISTL_INTERN_H
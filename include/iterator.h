@@ -19,7 +19,7 @@ struct iterator_traits {
     typedef typename I::value_type          value_type;
     typedef typename I::difference_type     difference_type;
     typedef typename I::pointer             pointer;
-    typedef typename I::reference           refernece;
+    typedef typename I::reference           reference;
 };
 
 
@@ -109,7 +109,8 @@ inline void _advance(BidirectionalIterator& i, Distance n,
 }
 
 template <typename RandomAccessIterator, typename Distance>
-inline void _advance(RandomAccessIterator& i, Distance n) {
+inline void _advance(RandomAccessIterator& i, Distance n,
+                     random_access_iterator_tag) {
     i += n;
 }
 
@@ -0,0 +1,209 @@
+#ifndef MINISTL_MEMORY_RESOURCE_H
+#define MINISTL_MEMORY_RESOURCE_H
+
+#include <stddef.h>
+#include <climits>      // for UINT_MAX
+#include <atomic>
+#include "alloc.h"
+#include "arena.h"
+#include "constructor.h"
+
+namespace ministl {
+
+/**
+ * 运行时选择的内存来源
+ * allocator<T, Alloc> 在编译期通过 Alloc 决定内存来源，换一种来源就换了容器的类型
+ * memory_resource 通过虚函数分配内存，polymorphic_allocator<T> 保存一个 memory_resource 的指针
+ * 同一个 vector<T, polymorphic_allocator<T> > 类型的不同对象可以使用不同的内存来源
+ * 与 std::pmr 中的设计相同
+ */
+class memory_resource {
+
+public:
+    static const size_t DEFAULT_ALIGN = alignof(max_align_t);
+
+    virtual ~memory_resource() { }
+
+    void * allocate(size_t bytes, size_t align = DEFAULT_ALIGN) {
+        return do_allocate(bytes, align);
+    }
+
+    void deallocate(void *p, size_t bytes, size_t align = DEFAULT_ALIGN) {
+        do_deallocate(p, bytes, align);
+    }
+
+    // 一个 resource 分配的内存可以由另一个 resource 归还时，两者相等
+    bool is_equal(const memory_resource & other) const noexcept {
+        return this == &other || do_is_equal(other);
+    }
+
+protected:
+    virtual void * do_allocate(size_t bytes, size_t align) = 0;
+    virtual void do_deallocate(void *p, size_t bytes, size_t align) = 0;
+    virtual bool do_is_equal(const memory_resource & other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource & lhs, const memory_resource & rhs) {
+    return lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource & lhs, const memory_resource & rhs) {
+    return !lhs.is_equal(rhs);
+}
+
+/**
+ * 把静态接口的配置器 (default_alloc_template、malloc_alloc 等) 包装成 memory_resource
+ * 对齐要求不超过 8 字节时调用 Alloc::allocate，否则调用 Alloc::allocate_aligned
+ * Alloc 相同的两个 alloc_resource 共享同一个内存池，所以相等
+ */
+template <typename Alloc>
+class alloc_resource : public memory_resource {
+
+protected:
+    void * do_allocate(size_t bytes, size_t align) {
+        if (0 == bytes) bytes = 1;
+        return align <= 8 ? Alloc::allocate(bytes) : Alloc::allocate_aligned(bytes, align);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t align) {
+        if (0 == bytes) bytes = 1;
+        if (align <= 8) Alloc::deallocate(p, bytes);
+        else Alloc::deallocate_aligned(p, bytes, align);
+    }
+
+    bool do_is_equal(const memory_resource & other) const noexcept {
+        return nullptr != dynamic_cast<const alloc_resource<Alloc> *>(&other);
+    }
+};
+
+// 使用二级配置器的内存池
+typedef alloc_resource<default_alloc_template> pool_resource;
+// 直接使用 malloc
+typedef alloc_resource<malloc_alloc> malloc_resource;
+// 内存池的 chunk 来自 2MB 对齐的大页
+typedef alloc_resource<pool_alloc_template<geometric_size_class<4096>, mmap_chunk_source> >
+    mmap_pool_resource;
+
+/**
+ * 单调内存区，每个对象拥有自己的 monotonic_arena
+ * deallocate 什么也不做，release() 或析构时一次性归还所有内存
+ * 不是线程安全的
+ */
+class monotonic_resource : public memory_resource {
+
+public:
+    explicit monotonic_resource(size_t initial_bytes = 4096) : arena(initial_bytes) { }
+
+    void release() { arena.release(); }
+
+    size_t bytes_allocated() const { return arena.bytes_allocated(); }
+
+protected:
+    void * do_allocate(size_t bytes, size_t align) {
+        return arena.allocate(bytes, align < DEFAULT_ALIGN ? DEFAULT_ALIGN : align);
+    }
+
+    void do_deallocate(void *, size_t, size_t) { }
+
+    bool do_is_equal(const memory_resource & other) const noexcept {
+        return this == &other;
+    }
+
+private:
+    monotonic_arena arena;
+};
+
+inline memory_resource * _builtin_resource() {
+    static pool_resource pool;
+    return &pool;
+}
+
+// 默认的内存来源，默认构造的 polymorphic_allocator 使用它
+inline std::atomic<memory_resource *> & _default_resource() {
+    static std::atomic<memory_resource *> resource(_builtin_resource());
+    return resource;
+}
+
+inline memory_resource * get_default_resource() {
+    return _default_resource().load(std::memory_order_acquire);
+}
+
+// 设置默认的内存来源，返回之前的来源，r 为 nullptr 时恢复为 pool_resource
+inline memory_resource * set_default_resource(memory_resource * r) {
+    return _default_resource().exchange(r ? r : _builtin_resource(), std::memory_order_acq_rel);
+}
+
+/**
+ * 有状态的配置器，从它保存的 memory_resource 分配内存
+ * 作为 vector 的 Alloc 参数时保存在 vector 的 data_allocator 中
+ * 复制 vector 时新的 vector 使用同一个 memory_resource
+ * rebind 之后的配置器仍然使用同一个 memory_resource
+ */
+template <typename T>
+class polymorphic_allocator {
+
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef polymorphic_allocator<U> other;
+    };
+
+    polymorphic_allocator() noexcept : res(get_default_resource()) { }
+
+    polymorphic_allocator(memory_resource * r) noexcept : res(r) { }
+
+    template <typename U>
+    polymorphic_allocator(const polymorphic_allocator<U> & other) noexcept
+        : res(other.resource()) { }
+
+    pointer allocate(size_type n, const void* = 0) {
+        return 0 == n ? nullptr : (pointer) res->allocate(n * sizeof(T), alignof(T));
+    }
+
+    void deallocate(pointer p, size_type n) {
+        if (0 != n) res->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    void construct(pointer p, const T& value) {
+        ministl::construct(p, value);
+    }
+
+    void destroy(pointer p) {
+        ministl::destroy(p);
+    }
+
+    pointer address(reference x) const { return &x; }
+
+    const_pointer address(const_reference x) const { return &x; }
+
+    size_type max_size() const {
+        return size_type(UINT_MAX/sizeof(T));
+    }
+
+    memory_resource * resource() const { return res; }
+
+private:
+    memory_resource * res;
+};
+
+template <typename T, typename U>
+inline bool operator==(const polymorphic_allocator<T> & lhs, const polymorphic_allocator<U> & rhs) {
+    return *lhs.resource() == *rhs.resource();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const polymorphic_allocator<T> & lhs, const polymorphic_allocator<U> & rhs) {
+    return !(lhs == rhs);
+}
+
+}
+
+#endif // MINISTL_MEMORY_RESOURCE_H
@@ -0,0 +1,209 @@
+#ifndef MINISTL_PARALLEL_H
+#define MINISTL_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>         // for uintptr_t
+#include <exception>        // for exception_ptr
+#include <memory>           // for unique_ptr
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>        // for pthread_setaffinity_np
+#include <sched.h>
+#endif
+#include "iterator.h"
+#include "uninitialized.h"
+#include "vector.h"
+
+namespace ministl {
+
+/**
+ * 并行构造，作为 uninitialized_fill_n 等函数的第一个参数或 vector 构造函数的参数
+ *     vector<double> v(n, 0.0, parallel);
+ *     ministl::uninitialized_copy(parallel_t(8), first, last, result);
+ *
+ * 区间被分成若干段，每段由一个线程构造，第 0 段在调用者的线程上执行
+ * 段的边界按地址对齐到页 (4096 字节)，每一页只被一个线程第一次写入 (元素跨页时除外)
+ * Linux 的默认策略把页分配在第一次写入它的线程所在的 NUMA 节点上，
+ * 所以大数组的物理页分布在所有工作线程的节点上，之后由同样划分的并行代码访问时都是本地内存
+ * pin 为 true 时第 i 个工作线程绑定到第 i 个 CPU，页的分布是确定的
+ *
+ * 只有每个线程至少分到 min_bytes 字节时才会启动线程，小区间直接顺序构造
+ * 异常安全与顺序版本相同：任何一段失败时析构其他段已经构造的元素，重新抛出第一个异常
+ */
+struct parallel_t {
+    unsigned int threads;       // 线程数，0 表示 std::thread::hardware_concurrency()
+    bool pin;                   // 工作线程是否绑定 CPU
+    size_t min_bytes;           // 每个线程至少处理的字节数
+
+    explicit parallel_t(unsigned int n = 0, bool pin_threads = false,
+                        size_t min_chunk_bytes = 4 * 1024 * 1024)
+        : threads(n), pin(pin_threads), min_bytes(min_chunk_bytes) { }
+
+    // 处理 bytes 字节时使用的线程数
+    size_t threads_for(size_t bytes) const {
+        size_t n = threads ? threads : std::thread::hardware_concurrency();
+        size_t limit = min_bytes ? bytes / min_bytes : n;
+        if (n > limit) n = limit;
+        return n ? n : 1;
+    }
+};
+
+static const parallel_t parallel = parallel_t();
+
+inline void _pin_to_cpu(size_t i) {
+#if defined(__linux__)
+    unsigned int cpus = std::thread::hardware_concurrency();
+    if (0 == cpus) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(i % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) i;
+#endif
+}
+
+/**
+ * 把 [0, n) 分段，每段在一个线程上调用 construct(begin, end)
+ * base 是第 0 个元素的地址，段的起始元素是地址不小于页边界的第一个元素
+ * 有段失败时对其他成功的段调用 destroy(begin, end)，然后重新抛出第一个异常
+ * 无法创建线程时该段在调用者的线程上执行
+ */
+template <typename Construct, typename Destroy>
+void _parallel_construct(const parallel_t& p, const void *base, size_t n, size_t elem_size,
+                         Construct construct, Destroy destroy) {
+    const uintptr_t PAGE = 4096;
+    size_t threads = p.threads_for(n * elem_size);
+    if (threads <= 1) {
+        construct(size_t(0), n);
+        return;
+    }
+
+    // 第 i 段的起始下标：把均分的位置按地址上调到页边界
+    // 区间的起始地址不一定按页对齐，按下标取整会让每个边界都落在页的中间
+    const uintptr_t addr = (uintptr_t) base;
+    const size_t chunk = (n + threads - 1) / threads;
+    auto bound = [&](size_t i) -> size_t {
+        if (0 == i) return 0;
+        if (i * chunk >= n) return n;
+        uintptr_t page = (addr + i * chunk * elem_size + PAGE - 1) & ~(PAGE - 1);
+        size_t b = (page - addr + elem_size - 1) / elem_size;
+        return b < n ? b : n;
+    };
+
+    std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[threads]);
+    std::unique_ptr<std::thread[]> workers(new std::thread[threads]);
+    auto run = [&](size_t i) {
+        if (p.pin && i != 0) _pin_to_cpu(i);
+        size_t b = bound(i);
+        size_t e = bound(i + 1);
+        try {
+            construct(b, e);
+        }
+        catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    for (size_t i = 1; i < threads; ++i) {
+        try {
+            workers[i] = std::thread(run, i);
+        }
+        catch (...) {
+            run(i);
+        }
+    }
+    run(0);
+    for (size_t i = 1; i < threads; ++i)
+        if (workers[i].joinable())
+            workers[i].join();
+
+    size_t failed = threads;
+    for (size_t i = 0; i < threads && failed == threads; ++i)
+        if (errors[i]) failed = i;
+    if (failed == threads) return;
+    // commit or rollback，失败的段已经析构了自己构造的元素
+    for (size_t i = 0; i < threads; ++i) {
+        if (errors[i]) continue;
+        destroy(bound(i), bound(i + 1));
+    }
+    std::rethrow_exception(errors[failed]);
+}
+
+template <typename RandomAccessIterator, typename Size, typename T>
+RandomAccessIterator uninitialized_fill_n(const parallel_t& p, RandomAccessIterator first,
+                                          Size n, const T& x) {
+    typedef typename iterator_traits<RandomAccessIterator>::value_type V;
+    _parallel_construct(p, n ? &*first : nullptr, size_t(n), sizeof(V),
+        [&](size_t b, size_t e) { ministl::uninitialized_fill_n(first + b, e - b, x); },
+        [&](size_t b, size_t e) { ministl::destroy(first + b, first + e); });
+    return first + n;
+}
+
+template <typename RandomAccessIterator1, typename RandomAccessIterator2>
+RandomAccessIterator2 uninitialized_copy(const parallel_t& p, RandomAccessIterator1 first,
+                                         RandomAccessIterator1 last, RandomAccessIterator2 result) {
+    typedef typename iterator_traits<RandomAccessIterator2>::value_type V;
+    const size_t n = last - first;
+    _parallel_construct(p, n ? &*result : nullptr, n, sizeof(V),
+        [&](size_t b, size_t e) { ministl::uninitialized_copy(first + b, first + e, result + b); },
+        [&](size_t b, size_t e) { ministl::destroy(result + b, result + e); });
+    return result + n;
+}
+
+// 对于有 trivial default constructor 的类型什么也不做，页不会被写入
+template <typename RandomAccessIterator, typename Size>
+RandomAccessIterator uninitialized_default_n(const parallel_t& p, RandomAccessIterator first, Size n) {
+    typedef typename iterator_traits<RandomAccessIterator>::value_type V;
+    _parallel_construct(p, n ? &*first : nullptr, size_t(n), sizeof(V),
+        [&](size_t b, size_t e) { ministl::uninitialized_default_n(first + b, e - b); },
+        [&](size_t b, size_t e) { ministl::destroy(first + b, first + e); });
+    return first + n;
+}
+
+// vector 的并行构造和 resize，声明在 vector.h 中
+
+template <typename T, typename Alloc, typename Growth>
+vector<T, Alloc, Growth>::vector(size_type n, const T& value, const parallel_t& p,
+                                 const allocator_type& a) : base(a) {
+    start = data_allocator.allocate(n);
+    try {
+        finish = ministl::uninitialized_fill_n(p, start, n, value);
+    }
+    catch (...) {
+        data_allocator.deallocate(start, n);
+        throw;
+    }
+    end_of_storage = start + n;
+}
+
+template <typename T, typename Alloc, typename Growth>
+vector<T, Alloc, Growth>::vector(const_iterator first, const_iterator last, const parallel_t& p,
+                                 const allocator_type& a) : base(a) {
+    const size_type n = last - first;
+    start = data_allocator.allocate(n);
+    try {
+        finish = ministl::uninitialized_copy(p, first, last, start);
+    }
+    catch (...) {
+        data_allocator.deallocate(start, n);
+        throw;
+    }
+    end_of_storage = start + n;
+}
+
+template <typename T, typename Alloc, typename Growth>
+void vector<T, Alloc, Growth>::resize(size_type new_size, const T& x, const parallel_t& p) {
+    if (new_size < size())
+        erase(this->begin() + new_size, this->end());
+    else if (new_size > size()) {
+        // x 可能引用原有元素，扩容之前先复制一份
+        T x_copy = x;
+        if (new_size > capacity())
+            reallocate_storage(next_capacity(new_size), use_reallocate());
+        finish = ministl::uninitialized_fill_n(p, finish, new_size - size(), x_copy);
+    }
+}
+
+}
+
+#endif // MINISTL_PARALLEL_H
@@ -0,0 +1,570 @@
+#ifndef MINISTL_ROPE_H
+#define MINISTL_ROPE_H
+
+#include <atomic>
+#include <cstring>      // for memcpy, memcmp
+#include <new>          // for placement new
+#include <stdexcept>    // for out_of_range
+#include "allocator.h"
+#include "string.h"
+#include "string_view.h"
+
+namespace ministl {
+
+/**
+ * rope 的节点，创建之后不再修改，可以被多个 rope 共享
+ *     叶节点：left == right == nullptr，字符紧跟在节点之后，与节点在同一个区块中
+ *     连接节点：left 和 right 都不为空，size 是两者之和
+ * depth 是子树的高度，叶节点为 0，连接节点的左右子树高度最多相差 1 (AVL)
+ * 引用计数是原子的，不同线程中共享同一个节点的 rope 可以各自复制和析构
+ */
+struct _rope_rep {
+    std::atomic<size_t> refcount;
+    size_t size;
+    int depth;
+    _rope_rep *left;
+    _rope_rep *right;
+
+    bool is_leaf() const { return nullptr == left; }
+    char * data() { return reinterpret_cast<char *>(this + 1); }
+    const char * data() const { return reinterpret_cast<const char *>(this + 1); }
+};
+
+/**
+ * 适合大文本和频繁编辑的字符串 (cord)
+ * 字符分散在若干个叶节点中，叶节点之间由平衡的二叉树连接，节点带引用计数，被所有的副本共享
+ *     复制 rope                  O(1)，只增加根节点的引用计数
+ *     连接、插入、删除、substr   O(log n)，只创建路径上的新节点，其余的节点与原来的 rope 共享
+ *     operator[]                 O(log n)
+ * 切分叶节点时复制它的一部分，叶节点最多 MAX_LEAF 个字符，所以每次编辑复制的字符数有上限
+ * 连接时相邻的两个短叶节点合并成一个，逐个字符追加不会得到很多很小的叶节点
+ *
+ * chunk_begin() / chunk_end() 按顺序遍历叶节点，每个块是一个 string_view，可以直接用于 writev：
+ *     for (rope::chunk_iterator it = r.chunk_begin(); it != r.chunk_end(); ++it, ++n) {
+ *         iov[n].iov_base = (void *) it->data();
+ *         iov[n].iov_len = it->size();
+ *     }
+ * 节点由 allocator<char> 分配
+ */
+class rope {
+
+public:
+    typedef char            value_type;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+
+    typedef allocator<char> data_allocator;
+
+    static const size_type npos = size_type(-1);
+
+    // 叶节点连同节点头一共 4096 字节
+    static const size_type MAX_LEAF = 4096 - sizeof(_rope_rep);
+    // 合并之后不超过 MERGE_LEAF 个字符的相邻叶节点会被合并
+    static const size_type MERGE_LEAF = 256;
+    // AVL 树的高度不超过 1.44 * log2(节点数)
+    static const int MAX_DEPTH = 96;
+
+    class chunk_iterator;
+
+    rope() : root(nullptr) { }
+
+    explicit rope(string_view s) : root(build(s.data(), s.size())) { }
+
+    rope(const rope &r) : root(add_ref(r.root)) { }
+
+    rope(rope &&r) noexcept : root(r.root) { r.root = nullptr; }
+
+    rope& operator= (const rope &rhs) {
+        _rope_rep *p = add_ref(rhs.root);
+        release(root);
+        root = p;
+        return *this;
+    }
+
+    rope& operator= (rope &&rhs) noexcept {
+        if (this != &rhs) {
+            release(root);
+            root = rhs.root;
+            rhs.root = nullptr;
+        }
+        return *this;
+    }
+
+    ~rope() { release(root); }
+
+    size_type size() const { return root ? root->size : 0; }
+    size_type length() const { return size(); }
+    bool empty() const { return nullptr == root; }
+    int depth() const { return height(root); }
+
+    char operator[](size_type n) const {
+        const _rope_rep *p = root;
+        while (!p->is_leaf()) {
+            if (n < p->left->size) {
+                p = p->left;
+            }
+            else {
+                n -= p->left->size;
+                p = p->right;
+            }
+        }
+        return p->data()[n];
+    }
+
+    char at(size_type n) const {
+        if (n >= size()) throw std::out_of_range("ministl::rope");
+        return (*this)[n];
+    }
+
+    void clear() {
+        release(root);
+        root = nullptr;
+    }
+
+    rope& append(const rope &r) {
+        replace_root(join(root, r.root));
+        return *this;
+    }
+
+    rope& append(string_view s) {
+        return append(rope(s));
+    }
+
+    rope& operator+= (const rope &r) { return append(r); }
+    rope& operator+= (string_view s) { return append(s); }
+
+    // 在下标 pos 处插入
+    rope& insert(size_type pos, const rope &r) {
+        check_pos(pos);
+        _rope_rep *l, *rr;
+        split(root, pos, l, rr);
+        _rope_rep *t = join(l, r.root);
+        release(l);
+        _rope_rep *p = join(t, rr);
+        release(t);
+        release(rr);
+        replace_root(p);
+        return *this;
+    }
+
+    rope& insert(size_type pos, string_view s) {
+        return insert(pos, rope(s));
+    }
+
+    // 删除从下标 pos 开始的 n 个字符，n 超出末尾时删除到末尾
+    rope& erase(size_type pos, size_type n = npos) {
+        check_pos(pos);
+        if (n > size() - pos) n = size() - pos;
+        _rope_rep *l, *r, *m, *rr;
+        split(root, pos, l, r);
+        split(r, n, m, rr);
+        release(r);
+        release(m);
+        _rope_rep *p = join(l, rr);
+        release(l);
+        release(rr);
+        replace_root(p);
+        return *this;
+    }
+
+    // 从 pos 开始的至多 n 个字符，与 *this 共享节点
+    rope substr(size_type pos = 0, size_type n = npos) const {
+        check_pos(pos);
+        if (n > size() - pos) n = size() - pos;
+        _rope_rep *l, *r, *m, *rr;
+        split(root, pos, l, r);
+        release(l);
+        split(r, n, m, rr);
+        release(r);
+        release(rr);
+        rope result;
+        result.root = m;
+        return result;
+    }
+
+    // 按字节比较，返回值的符号与 memcmp 相同
+    int compare(const rope &r) const;
+
+    string to_string() const;
+
+    chunk_iterator chunk_begin() const;
+    chunk_iterator chunk_end() const;
+
+    void swap(rope &r) noexcept {
+        _rope_rep *tmp = root;
+        root = r.root;
+        r.root = tmp;
+    }
+
+private:
+    _rope_rep *root;        // 空的 rope 为 nullptr
+
+    void check_pos(size_type pos) const {
+        if (pos > size()) throw std::out_of_range("ministl::rope");
+    }
+
+    void replace_root(_rope_rep *p) {
+        release(root);
+        root = p;
+    }
+
+    static int height(const _rope_rep *p) { return p ? p->depth : -1; }
+
+    static _rope_rep * add_ref(_rope_rep *p) {
+        if (p) p->refcount.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    static void release(_rope_rep *p) {
+        if (p && 1 == p->refcount.fetch_sub(1, std::memory_order_acq_rel)) {
+            size_type bytes = sizeof(_rope_rep);
+            if (p->is_leaf()) {
+                bytes += p->size;
+            }
+            else {
+                release(p->left);
+                release(p->right);
+            }
+            p->~_rope_rep();
+            data_allocator().deallocate(reinterpret_cast<char *>(p), bytes);
+        }
+    }
+
+    static _rope_rep * new_rep(size_type bytes) {
+        _rope_rep *p = reinterpret_cast<_rope_rep *>(data_allocator::allocate(bytes));
+        ::new (p) _rope_rep();
+        p->refcount.store(1, std::memory_order_relaxed);
+        return p;
+    }
+
+    // 由 [s, s+n) 和 [t, t+m) 拼接成的叶节点
+    static _rope_rep * new_leaf(const char *s, size_type n, const char *t = nullptr, size_type m = 0) {
+        _rope_rep *p = new_rep(sizeof(_rope_rep) + n + m);
+        p->size = n + m;
+        p->depth = 0;
+        p->left = p->right = nullptr;
+        memcpy(p->data(), s, n);
+        if (m) memcpy(p->data() + n, t, m);
+        return p;
+    }
+
+    // 接管 l 和 r 的引用，分配失败时释放它们
+    static _rope_rep * new_concat(_rope_rep *l, _rope_rep *r) {
+        _rope_rep *p;
+        try {
+            p = new_rep(sizeof(_rope_rep));
+        }
+        catch (...) {
+            release(l);
+            release(r);
+            throw;
+        }
+        p->size = l->size + r->size;
+        p->depth = (l->depth > r->depth ? l->depth : r->depth) + 1;
+        p->left = l;
+        p->right = r;
+        return p;
+    }
+
+    // 以下函数的参数都是借用的，返回的节点带有一个引用
+
+    static _rope_rep * make_concat(_rope_rep *l, _rope_rep *r) {
+        return new_concat(add_ref(l), add_ref(r));
+    }
+
+    // [s, s+n) 切成 MAX_LEAF 大小的叶节点，建成完全平衡的树
+    static _rope_rep * build(const char *s, size_type n);
+
+    // a 和 b 的高度最多相差 2，必要时旋转
+    static _rope_rep * balance(_rope_rep *a, _rope_rep *b);
+
+    // AVL 的 join：沿较高一侧的边向下，直到高度相差不超过 1，回来的路上重新平衡
+    static _rope_rep * join(_rope_rep *l, _rope_rep *r);
+
+    // [0, pos) 和 [pos, size)
+    static void split(_rope_rep *p, size_type pos, _rope_rep *&l, _rope_rep *&r);
+};
+
+inline _rope_rep * rope::build(const char *s, size_type n) {
+    if (0 == n) return nullptr;
+    if (n <= MAX_LEAF) return new_leaf(s, n);
+    size_type leaves = (n + MAX_LEAF - 1) / MAX_LEAF;
+    size_type mid = leaves / 2 * MAX_LEAF;
+    _rope_rep *l = build(s, mid);
+    _rope_rep *r;
+    try {
+        r = build(s + mid, n - mid);
+    }
+    catch (...) {
+        release(l);
+        throw;
+    }
+    return new_concat(l, r);
+}
+
+inline _rope_rep * rope::balance(_rope_rep *a, _rope_rep *b) {
+    int ha = height(a), hb = height(b);
+    if (hb > ha + 1) {
+        if (height(b->left) > height(b->right)) {
+            // 先右旋 b 再左旋
+            _rope_rep *x = make_concat(a, b->left->left);
+            _rope_rep *y;
+            try {
+                y = make_concat(b->left->right, b->right);
+            }
+            catch (...) {
+                release(x);
+                throw;
+            }
+            return new_concat(x, y);
+        }
+        return new_concat(make_concat(a, b->left), add_ref(b->right));
+    }
+    if (ha > hb + 1) {
+        if (height(a->right) > height(a->left)) {
+            _rope_rep *x = make_concat(a->left, a->right->left);
+            _rope_rep *y;
+            try {
+                y = make_concat(a->right->right, b);
+            }
+            catch (...) {
+                release(x);
+                throw;
+            }
+            return new_concat(x, y);
+        }
+        _rope_rep *y = make_concat(a->right, b);
+        return new_concat(add_ref(a->left), y);
+    }
+    return make_concat(a, b);
+}
+
+inline _rope_rep * rope::join(_rope_rep *l, _rope_rep *r) {
+    if (!l) return add_ref(r);
+    if (!r) return add_ref(l);
+
+    // 合并相邻的短叶节点
+    if (r->is_leaf() && r->size < MERGE_LEAF) {
+        if (l->is_leaf() && l->size + r->size <= MERGE_LEAF)
+            return new_leaf(l->data(), l->size, r->data(), r->size);
+        if (!l->is_leaf() && l->right->is_leaf() && l->right->size + r->size <= MERGE_LEAF) {
+            _rope_rep *m = new_leaf(l->right->data(), l->right->size, r->data(), r->size);
+            _rope_rep *p;
+            try {
+                p = join(l->left, m);
+            }
+            catch (...) {
+                release(m);
+                throw;
+            }
+            release(m);
+            return p;
+        }
+    }
+    if (l->is_leaf() && l->size < MERGE_LEAF && !r->is_leaf()
+        && r->left->is_leaf() && l->size + r->left->size <= MERGE_LEAF) {
+        _rope_rep *m = new_leaf(l->data(), l->size, r->left->data(), r->left->size);
+        _rope_rep *p;
+        try {
+            p = join(m, r->right);
+        }
+        catch (...) {
+            release(m);
+            throw;
+        }
+        release(m);
+        return p;
+    }
+
+    _rope_rep *t, *p;
+    if (l->depth > r->depth + 1) {
+        t = join(l->right, r);
+        try {
+            p = balance(l->left, t);
+        }
+        catch (...) {
+            release(t);
+            throw;
+        }
+    }
+    else if (r->depth > l->depth + 1) {
+        t = join(l, r->left);
+        try {
+            p = balance(t, r->right);
+        }
+        catch (...) {
+            release(t);
+            throw;
+        }
+    }
+    else {
+        return make_concat(l, r);
+    }
+    release(t);
+    return p;
+}
+
+inline void rope::split(_rope_rep *p, size_type pos, _rope_rep *&l, _rope_rep *&r) {
+    if (!p || 0 == pos) {
+        l = nullptr;
+        r = add_ref(p);
+        return;
+    }
+    if (pos >= p->size) {
+        l = add_ref(p);
+        r = nullptr;
+        return;
+    }
+    if (p->is_leaf()) {
+        l = new_leaf(p->data(), pos);
+        try {
+            r = new_leaf(p->data() + pos, p->size - pos);
+        }
+        catch (...) {
+            release(l);
+            throw;
+        }
+        return;
+    }
+    size_type left_size = p->left->size;
+    if (pos <= left_size) {
+        _rope_rep *lr;
+        split(p->left, pos, l, lr);
+        try {
+            r = join(lr, p->right);
+        }
+        catch (...) {
+            release(l);
+            release(lr);
+            throw;
+        }
+        release(lr);
+    }
+    else {
+        _rope_rep *rl;
+        split(p->right, pos - left_size, rl, r);
+        try {
+            l = join(p->left, rl);
+        }
+        catch (...) {
+            release(rl);
+            release(r);
+            throw;
+        }
+        release(rl);
+    }
+}
+
+/**
+ * 按顺序遍历叶节点，*it 是当前叶节点的字符
+ * 栈中保存从根到当前叶节点的路径上，当前叶节点在其左子树中的连接节点
+ * rope 修改或析构之后迭代器失效
+ */
+class rope::chunk_iterator {
+    friend class rope;
+
+public:
+    typedef forward_iterator_tag    iterator_category;
+    typedef string_view             value_type;
+    typedef ptrdiff_t               difference_type;
+    typedef const string_view*      pointer;
+    typedef const string_view&      reference;
+
+    chunk_iterator() : top(-1) { }
+
+    reference operator*() const { return chunk; }
+    pointer operator->() const { return &chunk; }
+
+    chunk_iterator& operator++() {
+        --top;
+        if (top >= 0) descend(stack[top--]->right);
+        else chunk = string_view();
+        return *this;
+    }
+
+    chunk_iterator operator++(int) {
+        chunk_iterator tmp = *this;
+        ++*this;
+        return tmp;
+    }
+
+    bool operator== (const chunk_iterator &x) const {
+        return top == x.top && (top < 0 || stack[top] == x.stack[top]);
+    }
+    bool operator!= (const chunk_iterator &x) const { return !(*this == x); }
+
+private:
+    const _rope_rep *stack[rope::MAX_DEPTH];
+    int top;                // 栈顶的下标，-1 表示末尾
+    string_view chunk;
+
+    // 压入 p 和它左边缘上的所有节点
+    void descend(const _rope_rep *p) {
+        while (!p->is_leaf()) {
+            stack[++top] = p;
+            p = p->left;
+        }
+        stack[++top] = p;
+        chunk = string_view(p->data(), p->size);
+    }
+};
+
+inline rope::chunk_iterator rope::chunk_begin() const {
+    chunk_iterator it;
+    if (root) it.descend(root);
+    return it;
+}
+
+inline rope::chunk_iterator rope::chunk_end() const {
+    return chunk_iterator();
+}
+
+inline int rope::compare(const rope &r) const {
+    chunk_iterator a = chunk_begin(), b = r.chunk_begin(), end = chunk_end();
+    string_view x, y;
+    for (;;) {
+        if (x.empty() && a != end) { x = *a; ++a; }
+        if (y.empty() && b != end) { y = *b; ++b; }
+        if (x.empty() || y.empty())
+            return x.empty() ? (y.empty() ? 0 : -1) : 1;
+        size_type n = x.size() < y.size() ? x.size() : y.size();
+        int c = memcmp(x.data(), y.data(), n);
+        if (c != 0) return c;
+        x.remove_prefix(n);
+        y.remove_prefix(n);
+    }
+}
+
+inline string rope::to_string() const {
+    string s;
+    s.reserve(size());
+    for (chunk_iterator it = chunk_begin(); it != chunk_end(); ++it)
+        s.append(*it);
+    return s;
+}
+
+inline rope operator+ (const rope &lhs, const rope &rhs) {
+    rope result(lhs);
+    result.append(rhs);
+    return result;
+}
+
+inline bool operator== (const rope &lhs, const rope &rhs) {
+    return lhs.size() == rhs.size() && 0 == lhs.compare(rhs);
+}
+inline bool operator!= (const rope &lhs, const rope &rhs) { return !(lhs == rhs); }
+inline bool operator< (const rope &lhs, const rope &rhs) { return lhs.compare(rhs) < 0; }
+
+inline void swap(rope &lhs, rope &rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+inline std::ostream& operator<< (std::ostream& os, const rope& r) {
+    for (rope::chunk_iterator it = r.chunk_begin(); it != r.chunk_end(); ++it)
+        os << *it;
+    return os;
+}
+
+}
+
+#endif // MINISTL_ROPE_H
@@ -0,0 +1,105 @@
+#ifndef MINISTL_SIZE_CLASS_H
+#define MINISTL_SIZE_CLASS_H
+
+#include <stddef.h>
+
+namespace ministl {
+
+/**
+ * 二级配置器的 size class 策略
+ * 一个 size class 策略需要提供：
+ * ALIGN        所有区块大小都是 ALIGN 的倍数
+ * MAX_BYTES    最大的区块大小，超过的请求交给一级配置器
+ * NFREELISTS   size class 的个数，即 free list 的个数
+ * index(n)     大小为 n (0 < n <= MAX_BYTES) 的请求所在 size class 的下标
+ * size(i)      第 i 个 size class 的区块大小
+ */
+
+// 求 2 的幂 n 的对数，用于编译期计算
+constexpr size_t _static_log2(size_t n) {
+    return n <= 1 ? 0 : 1 + _static_log2(n >> 1);
+}
+
+// 向下取整的 log2，n > 0
+inline size_t _floor_log2(size_t n) {
+#if defined(__GNUC__)
+    return sizeof(unsigned long) * 8 - 1 - __builtin_clzl((unsigned long) n);
+#else
+    size_t r = 0;
+    while (n >>= 1) ++r;
+    return r;
+#endif
+}
+
+/**
+ * 线性间距的 size class，也是 SGI_STL 中的做法
+ * 默认为 8 16 24 32 40 48 56 64 72 80 88 96 104 112 120 128
+ */
+template <size_t Align = 8, size_t MaxBytes = 128>
+struct linear_size_class {
+    static_assert(Align >= sizeof(void*) && (Align & (Align - 1)) == 0,
+                  "Align must be a power of two and can hold a pointer");
+    static_assert(MaxBytes % Align == 0, "MaxBytes must be a multiple of Align");
+
+    static const size_t ALIGN = Align;
+    static const size_t MAX_BYTES = MaxBytes;
+    static const size_t NFREELISTS = MaxBytes / Align;
+
+    static size_t index(size_t bytes) {
+        // ((bytes + 7)/8) - 1 的结果是从 0 开始的
+        return (bytes + ALIGN - 1) / ALIGN - 1;
+    }
+
+    static size_t size(size_t index) {
+        return (index + 1) * ALIGN;
+    }
+};
+
+/**
+ * 几何间距的 size class，参考 jemalloc
+ * 前 2 * Steps 个 size class 按 Align 线性增长，之后每个区间 (2^k, 2^(k+1)] 等分为 Steps 个
+ * Align = 8, Steps = 4, MaxBytes = 4096 时为：
+ * 8 16 24 32 40 48 56 64
+ * 80 96 112 128 | 160 192 224 256 | 320 384 448 512 | ... | 2560 3072 3584 4096
+ * 共 32 个 size class
+ * 区块大小比请求多出的部分小于区块大小的 1/(Steps+1)，即内部碎片不超过 20%
+ */
+template <size_t MaxBytes = 4096, size_t Steps = 4, size_t Align = 8>
+struct geometric_size_class {
+    static_assert(Align >= sizeof(void*) && (Align & (Align - 1)) == 0,
+                  "Align must be a power of two and can hold a pointer");
+    static_assert(Steps >= 1 && (Steps & (Steps - 1)) == 0,
+                  "Steps must be a power of two");
+    static_assert((MaxBytes & (MaxBytes - 1)) == 0 && MaxBytes >= 2 * Steps * Align,
+                  "MaxBytes must be a power of two and not less than 2 * Steps * Align");
+
+    static const size_t ALIGN = Align;
+    static const size_t MAX_BYTES = MaxBytes;
+    // 线性部分的最大区块大小
+    static const size_t LINEAR_MAX = 2 * Steps * Align;
+    static const size_t LG_STEPS = _static_log2(Steps);
+    static const size_t LG_LINEAR_MAX = _static_log2(LINEAR_MAX);
+    static const size_t NFREELISTS =
+        2 * Steps + (_static_log2(MaxBytes) - LG_LINEAR_MAX) * Steps;
+
+    static size_t index(size_t bytes) {
+        if (bytes <= LINEAR_MAX) return (bytes + ALIGN - 1) / ALIGN - 1;
+        // 2^k < bytes <= 2^(k+1)，这个区间中每个 size class 相差 2^k / Steps
+        size_t k = _floor_log2(bytes - 1);
+        size_t lg_step = k - LG_STEPS;
+        return 2 * Steps + (k - LG_LINEAR_MAX) * Steps
+                         + ((bytes - 1 - ((size_t) 1 << k)) >> lg_step);
+    }
+
+    static size_t size(size_t index) {
+        if (index < 2 * Steps) return (index + 1) * ALIGN;
+        size_t group = (index - 2 * Steps) / Steps;
+        size_t step = (index - 2 * Steps) % Steps;
+        size_t base = LINEAR_MAX << group;
+        return base + (step + 1) * (base >> LG_STEPS);
+    }
+};
+
+}
+
+#endif // MINISTL_SIZE_CLASS_H
@@ -0,0 +1,197 @@
+#ifndef MINISTL_SMALL_VECTOR_H
+#define MINISTL_SMALL_VECTOR_H
+
+#include <cstddef>
+#include <cstring>          // for memcpy
+#include <type_traits>      // for aligned_storage, is_nothrow_move_constructible
+#include "vector.h"
+
+namespace ministl {
+
+/**
+ * 带内联存储的 vector
+ * 对象内部有一块能容纳 N 个元素的空间，元素个数不超过 N 时不向配置器申请内存
+ * 超过 N 个时和 vector 一样从 Alloc 分配，插入、删除和扩容与 vector 共用 _vector_base，
+ * 同样按 Growth 增长，可以平凡重定位的元素在堆上时同样走 reallocate
+ * 迭代器是原生指针，insert / erase 的语义和迭代器失效规则与 vector 相同
+ * 注意：元素在内联空间中时，移动构造和 swap 需要逐个移动元素，迭代器随之失效
+ */
+template <typename T, size_t N, typename Alloc = ministl::allocator<T>, typename Growth = double_growth>
+class small_vector : public _vector_base<T, Alloc, Growth, small_vector<T, N, Alloc, Growth> > {
+    static_assert(N > 0, "small_vector needs at least one inline element");
+
+    typedef _vector_base<T, Alloc, Growth, small_vector<T, N, Alloc, Growth> > base;
+    friend class _vector_base<T, Alloc, Growth, small_vector<T, N, Alloc, Growth> >;
+
+public:
+    typedef typename base::value_type       value_type;
+    typedef typename base::pointer          pointer;
+    typedef typename base::const_pointer    const_pointer;
+    typedef typename base::iterator         iterator;
+    typedef typename base::const_iterator   const_iterator;
+    typedef typename base::reference        reference;
+    typedef typename base::const_reference  const_reference;
+    typedef typename base::size_type        size_type;
+    typedef typename base::difference_type  difference_type;
+    typedef typename base::allocator_type   allocator_type;
+    typedef typename base::growth_policy    growth_policy;
+
+    static const size_type inline_capacity = N;
+
+protected:
+    using base::data_allocator;
+    using base::start;
+    using base::finish;
+    using base::end_of_storage;
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buffer;     // 内联空间
+
+    iterator inline_begin() { return reinterpret_cast<iterator>(&buffer); }
+    const_iterator inline_begin() const { return reinterpret_cast<const_iterator>(&buffer); }
+
+    void reset_inline() {
+        start = finish = inline_begin();
+        end_of_storage = start + N;
+    }
+
+    // 内联空间不需要归还
+    void deallocate() {
+        if (!is_inline())
+            data_allocator.deallocate(start, end_of_storage - start);
+    }
+
+    // 内联空间不能交给 reallocate，分配新的区块后按字节复制，见 _vector_base::use_reallocate
+    iterator reallocate_block(size_type len) {
+        if (!is_inline()) return base::reallocate_block(len);
+        iterator p = data_allocator.allocate(len);
+        memcpy((void *) p, (const void *) start, this->size() * sizeof(T));
+        return p;
+    }
+
+    // 把元素移动到容量为 len 的空间，len 不大于 N 时移回内联空间
+    void relocate(size_type len);
+
+public:
+    using base::size;
+    using base::capacity;
+    using base::clear;
+
+    // 元素是否保存在内联空间中
+    bool is_inline() const
+        { return start == inline_begin(); }
+
+    small_vector() { reset_inline(); }
+    explicit small_vector(const allocator_type& a) : base(a) { reset_inline(); }
+    small_vector(size_type n, const T& value, const allocator_type& a = allocator_type())
+        : base(a) {
+        reset_inline();
+        this->append_n(n, value);
+    }
+    explicit small_vector(size_type n) {
+        reset_inline();
+        this->append_n(n, T());
+    }
+    small_vector(const_iterator first, const_iterator last,
+                 const allocator_type& a = allocator_type()) : base(a) {
+        reset_inline();
+        this->append(first, last);
+    }
+    small_vector(const small_vector& x) : base(x.get_allocator()) {
+        reset_inline();
+        this->append(x.begin(), x.end());
+    }
+    // x 的元素在堆上时直接接管，在内联空间中时逐个移动
+    small_vector(small_vector&& x) noexcept(std::is_nothrow_move_constructible<T>::value)
+        : base(x.data_allocator) {
+        if (x.is_inline()) {
+            reset_inline();
+            finish = ministl::uninitialized_move_if_noexcept(x.start, x.finish, start);
+            x.clear();
+        }
+        else {
+            start = x.start;
+            finish = x.finish;
+            end_of_storage = x.end_of_storage;
+            x.reset_inline();
+        }
+    }
+    small_vector& operator=(const small_vector& x) {
+        if (&x != this) this->assign_copy(x.begin(), x.end());
+        return *this;
+    }
+    small_vector& operator=(small_vector&& x);
+
+    ~small_vector() {
+        ministl::destroy(start, finish);
+        deallocate();
+    }
+
+    void swap(small_vector& x) {
+        if (!is_inline() && !x.is_inline()) {
+            allocator_type a = data_allocator;
+            data_allocator = x.data_allocator;
+            x.data_allocator = a;
+            iterator tmp = start; start = x.start; x.start = tmp;
+            tmp = finish; finish = x.finish; x.finish = tmp;
+            tmp = end_of_storage; end_of_storage = x.end_of_storage; x.end_of_storage = tmp;
+        }
+        else {
+            small_vector tmp(ministl::move(x));
+            x = ministl::move(*this);
+            *this = ministl::move(tmp);
+        }
+    }
+
+    // 元素个数不超过 N 时移回内联空间，否则释放多余的容量
+    void shrink_to_fit() {
+        if (is_inline()) return;
+        size_type len = size() <= N ? size() : _good_capacity<allocator_type>(size());
+        if (len < capacity()) relocate(len);
+    }
+};
+
+template <typename T, size_t N, typename Alloc, typename Growth>
+void small_vector<T, N, Alloc, Growth>::relocate(size_type len) {
+    iterator new_start;
+    if (len <= N) {
+        new_start = inline_begin();
+        len = N;
+    }
+    else
+        new_start = data_allocator.allocate(len);
+    iterator new_finish;
+    try {
+        new_finish = ministl::uninitialized_move_if_noexcept(start, finish, new_start);
+    }
+    catch (...) {
+        if (len > N) data_allocator.deallocate(new_start, len);
+        throw;
+    }
+    this->replace_storage(new_start, new_finish, len);
+}
+
+template <typename T, size_t N, typename Alloc, typename Growth>
+small_vector<T, N, Alloc, Growth>&
+small_vector<T, N, Alloc, Growth>::operator=(small_vector&& x) {
+    if (&x != this) {
+        if (!x.is_inline() && data_allocator == x.data_allocator) {
+            // 接管 x 在堆上的空间
+            ministl::destroy(start, finish);
+            deallocate();
+            start = x.start;
+            finish = x.finish;
+            end_of_storage = x.end_of_storage;
+            x.reset_inline();
+        }
+        else {
+            clear();
+            this->reserve(x.size());
+            finish = ministl::uninitialized_move_if_noexcept(x.start, x.finish, start);
+            x.clear();
+        }
+    }
+    return *this;
+}
+
+}
+
+#endif // MINISTL_SMALL_VECTOR_H
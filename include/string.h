@@ -2,128 +2,463 @@
 #define MINISTL_STRING_H
 
 #include <iostream>
+#include <cstring>      // for memcpy, memmove, strlen
+#include <stdexcept>    // for out_of_range
+#include "allocator.h"
+#include "string_view.h"
 #include "util.h"
-#ifdef MINISTL_ALLOCATOR_H
-    #include <allocator.h>
-#else
-    #include <memory>
-#endif
 
 namespace ministl {
 
 /**
- * 需要一个C类型的字符串作为存储，一个指针指向头，一个指针指向尾。
- * 目前使用std中的配置器
- * TODO allocator
+ * 带短字符串优化 (SSO) 的字符串
+ * 对象本身是 24 字节 (64 位平台)，两种表示共用这 24 字节：
+ *     短字符串：字符直接存放在对象内部，最多 SSO_CAPACITY = 23 个字符，不分配内存
+ *               最后一个字节存放 SSO_CAPACITY - size()，长度为 23 时它正好是结尾的 '\0'
+ *     长字符串：{ 指针, 长度, 容量 }，容量的最高字节被标记为 0x80，与短字符串区分
+ * 两种表示都以 '\0' 结尾，c_str() 不需要额外处理
+ * 短字符串的复制和移动只是复制 24 字节，没有分支以外的额外开销
+ *
+ * 长字符串区块由 allocator<char> 分配，比容量多一个字节存放 '\0'
+ * 空间不足时容量至少翻倍，并取整到内存池的 size class，逐个字符追加时均摊 O(1)
+ * char 可以平凡重定位，增长时交给 allocator::reallocate，大区块可以原地扩展
  */
 class string {
 
 public:
+    typedef char            value_type;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef char&           reference;
+    typedef const char&     const_reference;
+    typedef char*           pointer;
+    typedef const char*     const_pointer;
+    typedef char*           iterator;
+    typedef const char*     const_iterator;
+
+    typedef allocator<char> data_allocator;
+
+    static const size_type npos = size_type(-1);
+
+private:
+    struct heap_rep {
+        char *ptr;
+        size_type size;
+        size_type cap;      // 编码之后的容量，见 encode_cap
+    };
+
+    static const size_type REP_SIZE = sizeof(heap_rep);
+    static const size_type LAST = REP_SIZE - 1;
+
+    union rep_type {
+        heap_rep heap;
+        char inline_buf[REP_SIZE];
+    };
+
+public:
+    static const size_type SSO_CAPACITY = REP_SIZE - 1;
+
     // 默认构造函数
-    string() : elements(nullptr), cap(nullptr) {
-        _MINISTL_DEBUG("default constructor(string)\n");
-    }
+    string() { set_inline_size(0); }
 
     // C字符串构造函数
-    string(const char *);
+    string(const char *s) { init(s, strlen(s)); }
+
+    string(const char *s, size_type n) { init(s, n); }
+
+    explicit string(string_view s) { init(s.data(), s.size()); }
+
+    string(size_type n, char c) {
+        set_inline_size(0);
+        append(n, c);
+    }
 
     // 复制构造函数
-    string(const string &);
+    string(const string &s) {
+        if (s.is_inline())
+            rep = s.rep;        // 短字符串只需要复制 24 字节
+        else
+            init(s.data(), s.size());
+        _MINISTL_DEBUG("string copy constructor\n");
+    }
 
     /**
      * 移动构造函数
      * noexcept表示告诉标准库该构造函数不抛出任何异常
      * 这是因为移动不会分配任何新内存，仅仅是接管了实参的内存空间
+     * 短字符串和长字符串都只是复制 24 字节，然后把 s 置为空串
      */
-    string(string &&) noexcept;
+    string(string &&s) noexcept : rep(s.rep) {
+        s.set_inline_size(0);
+        _MINISTL_DEBUG("string move constructor\n");
+    }
 
     // 赋值运算符
-    string& operator= (const string &);
-    string& operator= (string &&) noexcept;
+    string& operator= (const string &rhs);
+    string& operator= (string &&rhs) noexcept;
+    string& operator= (const char *s) { return assign(s, strlen(s)); }
+
+    string& assign(const char *s, size_type n);
 
     // 析构函数
-    ~string();
+    ~string() { free(); }
 
-    char * begin() const { return elements; }
-    char * end() const { return cap; }
+    iterator begin() { return data(); }
+    const_iterator begin() const { return data(); }
+    iterator end() { return data() + size(); }
+    const_iterator end() const { return data() + size(); }
 
-private: 
-    static std::allocator<char> alloc;
-    std::pair<char *, char *> alloc_n_copy(const char *, const char *);
-    void free();
-    char *elements;
-    char *cap;
-};
+    size_type size() const {
+        return is_inline() ? SSO_CAPACITY - (unsigned char) rep.inline_buf[LAST] : rep.heap.size;
+    }
+    size_type length() const { return size(); }
+    size_type capacity() const {
+        return is_inline() ? SSO_CAPACITY : decode_cap(rep.heap.cap);
+    }
+    bool empty() const { return 0 == size(); }
 
-std::allocator<char> string::alloc;
+    char * data() { return is_inline() ? rep.inline_buf : rep.heap.ptr; }
+    const char * data() const { return is_inline() ? rep.inline_buf : rep.heap.ptr; }
+    const char * c_str() const { return data(); }
 
-string::string(const char * s) {
-    auto s1 = s;
-    while (*s1) {
-        ++s1;
+    // 引用 *this 的字符，*this 修改或析构之后失效
+    operator string_view() const { return string_view(data(), size()); }
+
+    reference operator[](size_type n) { return data()[n]; }
+    const_reference operator[](size_type n) const { return data()[n]; }
+    reference front() { return *begin(); }
+    const_reference front() const { return *begin(); }
+    reference back() { return *(end() - 1); }
+    const_reference back() const { return *(end() - 1); }
+
+    // 字符是否存放在对象内部
+    bool is_inline() const { return (unsigned char) rep.inline_buf[LAST] < 0x80; }
+
+    // 容量至少为 n，不会缩小
+    void reserve(size_type n) {
+        if (n > capacity()) reallocate_storage(n);
     }
-    auto newstr = alloc_n_copy(s, s1);
-    elements = newstr.first;
-    cap = newstr.second;
-    _MINISTL_DEBUG("string constructor with c_string\n");
-}
 
-string::string(const string & s) {
-    auto newdata = alloc_n_copy(s.begin(), s.end());
-    elements = newdata.first;
-    cap = newdata.second;
-    _MINISTL_DEBUG("string copy constructor\n");
-}
+    // 释放多余的容量，能放进对象内部时回到短字符串
+    void shrink_to_fit() {
+        if (!is_inline() && capacity() > good_capacity(size()))
+            reallocate_storage(size());
+    }
 
-// 移动相当于偷取了参数s中的资源，然乎把s中的置为nullptr，并没有内存分配
-string::string(string && s) noexcept : elements(s.elements), cap(s.cap) {
-    s.elements = s.cap = nullptr;
-    _MINISTL_DEBUG("string move constructor\n");
-}
+    void clear() { set_size(0); }
+
+    void resize(size_type n, char c = '\0') {
+        size_type len = size();
+        if (n <= len) set_size(n);
+        else append(n - len, c);
+    }
+
+    void push_back(char c) {
+        size_type len = size();
+        if (len == capacity()) grow(len + 1);
+        data()[len] = c;
+        set_size(len + 1);
+    }
+
+    void pop_back() { set_size(size() - 1); }
+
+    // s 可以指向 *this 内部
+    string& append(const char *s, size_type n);
+    string& append(const char *s) { return append(s, strlen(s)); }
+    string& append(const string &s) { return append(s.data(), s.size()); }
+    string& append(string_view s) { return append(s.data(), s.size()); }
+    string& append(size_type n, char c);
+
+    string& operator+= (const string &s) { return append(s.data(), s.size()); }
+    string& operator+= (const char *s) { return append(s, strlen(s)); }
+    string& operator+= (string_view s) { return append(s.data(), s.size()); }
+    string& operator+= (char c) { push_back(c); return *this; }
+
+    // 在下标 pos 处插入，s 可以指向 *this 内部
+    string& insert(size_type pos, const char *s, size_type n);
+    string& insert(size_type pos, const char *s) { return insert(pos, s, strlen(s)); }
+    string& insert(size_type pos, const string &s) { return insert(pos, s.data(), s.size()); }
+    string& insert(size_type pos, size_type n, char c);
+    iterator insert(const_iterator position, char c) {
+        size_type pos = position - begin();
+        insert(pos, size_type(1), c);
+        return begin() + pos;
+    }
+
+    // 删除从下标 pos 开始的 n 个字符，n 超出末尾时删除到末尾
+    string& erase(size_type pos = 0, size_type n = npos);
+    iterator erase(const_iterator position) {
+        size_type pos = position - begin();
+        erase(pos, 1);
+        return begin() + pos;
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        size_type pos = first - begin();
+        erase(pos, last - first);
+        return begin() + pos;
+    }
+
+    // 查找与比较，见 string_view
+    size_type find(char c, size_type pos = 0) const { return string_view(*this).find(c, pos); }
+    size_type find(string_view s, size_type pos = 0) const { return string_view(*this).find(s, pos); }
+    size_type rfind(char c, size_type pos = npos) const { return string_view(*this).rfind(c, pos); }
+    size_type rfind(string_view s, size_type pos = npos) const { return string_view(*this).rfind(s, pos); }
+    size_type find_first_of(string_view s, size_type pos = 0) const {
+        return string_view(*this).find_first_of(s, pos);
+    }
+    int compare(string_view s) const { return string_view(*this).compare(s); }
+
+    void swap(string &s) noexcept {
+        rep_type tmp = rep;
+        rep = s.rep;
+        s.rep = tmp;
+    }
+
+private:
+    rep_type rep;
+
+    // 最高字节为 0x80 的容量，在 rep 的最后一个字节上与短字符串的长度 (0 ~ 23) 区分
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static size_type encode_cap(size_type cap) { return (cap << 8) | 0x80; }
+    static size_type decode_cap(size_type cap) { return cap >> 8; }
+#else
+    static const size_type CAP_SHIFT = (sizeof(size_type) - 1) * 8;
+    static size_type encode_cap(size_type cap) { return cap | (size_type(0x80) << CAP_SHIFT); }
+    static size_type decode_cap(size_type cap) { return cap & ~(size_type(0xff) << CAP_SHIFT); }
+#endif
+
+    // 容纳 n 个字符的区块实际能容纳的字符个数 (不含 '\0')
+    static size_type good_capacity(size_type n) {
+        return _good_capacity<data_allocator>(n + 1) - 1;
+    }
+
+    void set_inline_size(size_type n) {
+        rep.inline_buf[n] = '\0';
+        rep.inline_buf[LAST] = char(SSO_CAPACITY - n);
+    }
+
+    // 修改长度并写入结尾的 '\0'，n 不能超过 capacity()
+    void set_size(size_type n) {
+        if (is_inline()) {
+            set_inline_size(n);
+        }
+        else {
+            rep.heap.ptr[n] = '\0';
+            rep.heap.size = n;
+        }
+    }
+
+    void set_heap(char *p, size_type n, size_type cap) {
+        rep.heap.ptr = p;
+        rep.heap.size = n;
+        rep.heap.cap = encode_cap(cap);
+    }
+
+    // 用 [s, s+n) 初始化，n 不超过 SSO_CAPACITY 时不分配内存
+    void init(const char *s, size_type n) {
+        if (n <= SSO_CAPACITY) {
+            memcpy(rep.inline_buf, s, n);
+            set_inline_size(n);
+        }
+        else {
+            size_type cap = good_capacity(n);
+            set_heap(alloc_n_copy(s, n, cap), n, cap);
+        }
+    }
+
+    // 分配 cap + 1 个字节，复制 [s, s+n) 并以 '\0' 结尾
+    static char * alloc_n_copy(const char *s, size_type n, size_type cap) {
+        char *p = data_allocator::allocate(cap + 1);
+        memcpy(p, s, n);
+        p[n] = '\0';
+        return p;
+    }
+
+    // 至少容纳 required 个字符，容量翻倍
+    void grow(size_type required) {
+        size_type len = capacity() * 2;
+        reallocate_storage(len < required ? required : len);
+    }
+
+    // 容量改为 good_capacity(n)，n 不能小于 size()
+    void reallocate_storage(size_type n) {
+        size_type len = size();
+        if (n <= SSO_CAPACITY) {
+            if (is_inline()) return;
+            char *p = rep.heap.ptr;
+            size_type old_cap = capacity();
+            memcpy(rep.inline_buf, p, len);
+            set_inline_size(len);
+            data_allocator().deallocate(p, old_cap + 1);
+            return;
+        }
+        size_type cap = good_capacity(n);
+        if (is_inline())
+            set_heap(alloc_n_copy(rep.inline_buf, len, cap), len, cap);
+        else
+            set_heap(data_allocator::reallocate(rep.heap.ptr, capacity() + 1, cap + 1), len, cap);
+    }
+
+    // s 指向增长之前的 [old_data, old_data + old_size] 时，返回它增长之后的位置
+    const char * relocate(const char *s, const char *old_data, size_type old_size) const {
+        return (s >= old_data && s <= old_data + old_size) ? data() + (s - old_data) : s;
+    }
+
+    void check_pos(size_type pos) const {
+        if (pos > size()) throw std::out_of_range("ministl::string");
+    }
+
+    void free() {
+        if (!is_inline())
+            data_allocator().deallocate(rep.heap.ptr, decode_cap(rep.heap.cap) + 1);
+    }
+};
 
 // 对于二元运算符，统一使用rhs(right hand side)表示运算符右侧，lhs(left hand side)表示运算符左侧
-string& string::operator= (const string & rhs) {
-    auto newdata = alloc_n_copy(rhs.begin(), rhs.end());
-    free();
-    elements = newdata.first;
-    cap = newdata.second;
+inline string& string::operator= (const string & rhs) {
+    if (this != &rhs) {
+        if (rhs.is_inline()) {
+            free();
+            rep = rhs.rep;
+        }
+        else {
+            assign(rhs.data(), rhs.size());
+        }
+    }
     _MINISTL_DEBUG("string assignment operator\n");
     return *this;
 }
 
-string& string::operator= (string && rhs) noexcept {
+inline string& string::operator= (string && rhs) noexcept {
     // 对于移动赋值，都需要先判断两边是否是相等
     if (this != &rhs) {
         free();
-        elements = rhs.elements;
-        cap = rhs.cap;
-        rhs.elements = nullptr;
-        rhs.cap = nullptr;
+        rep = rhs.rep;
+        rhs.set_inline_size(0);
     }
     _MINISTL_DEBUG("string move assignment operator\n");
     return *this;
 }
 
-string::~string() {
-    free();
-    _MINISTL_DEBUG("string destructor\n");
+// 容量足够时复用原来的区块，否则先分配再释放，分配失败时 *this 不变
+inline string& string::assign(const char *s, size_type n) {
+    if (n <= capacity()) {
+        memmove(data(), s, n);
+        set_size(n);
+    }
+    else {
+        size_type cap = good_capacity(n);
+        char *p = alloc_n_copy(s, n, cap);
+        free();
+        set_heap(p, n, cap);
+    }
+    return *this;
+}
+
+inline string& string::append(const char *s, size_type n) {
+    size_type len = size();
+    if (n > capacity() - len) {
+        const char *old_data = data();
+        grow(len + n);
+        s = relocate(s, old_data, len);
+    }
+    memcpy(data() + len, s, n);
+    set_size(len + n);
+    return *this;
+}
+
+inline string& string::append(size_type n, char c) {
+    size_type len = size();
+    if (n > capacity() - len) grow(len + n);
+    memset(data() + len, c, n);
+    set_size(len + n);
+    return *this;
 }
 
-void string::free() {
-    if (elements) {
-        for (auto p = cap; p != elements; ) {
-            alloc.destroy(--p);
+inline string& string::insert(size_type pos, const char *s, size_type n) {
+    check_pos(pos);
+    size_type len = size();
+    if (n > capacity() - len) {
+        const char *old_data = data();
+        grow(len + n);
+        s = relocate(s, old_data, len);
+    }
+    char *p = data();
+    memmove(p + pos + n, p + pos, len - pos);
+    // s 指向 *this 时，插入点之后的部分已经后移了 n 个字节
+    if (s >= p && s < p + len) {
+        if (s + n <= p + pos) {
+            memcpy(p + pos, s, n);
+        }
+        else if (s >= p + pos) {
+            memcpy(p + pos, s + n, n);
         }
-        alloc.deallocate(elements, cap-elements);
+        else {
+            size_type before = p + pos - s;
+            memcpy(p + pos, s, before);
+            memcpy(p + pos + before, p + pos + n, n - before);
+        }
+    }
+    else {
+        memcpy(p + pos, s, n);
     }
+    set_size(len + n);
+    return *this;
+}
+
+inline string& string::insert(size_type pos, size_type n, char c) {
+    check_pos(pos);
+    size_type len = size();
+    if (n > capacity() - len) grow(len + n);
+    char *p = data();
+    memmove(p + pos + n, p + pos, len - pos);
+    memset(p + pos, c, n);
+    set_size(len + n);
+    return *this;
+}
+
+inline string& string::erase(size_type pos, size_type n) {
+    check_pos(pos);
+    size_type len = size();
+    if (n > len - pos) n = len - pos;
+    char *p = data();
+    memmove(p + pos, p + pos + n, len - pos - n);
+    set_size(len - n);
+    return *this;
+}
+
+inline string operator+ (const string &lhs, const string &rhs) {
+    string result;
+    result.reserve(lhs.size() + rhs.size());
+    result.append(lhs).append(rhs);
+    return result;
+}
+
+inline string operator+ (string &&lhs, const string &rhs) {
+    return ministl::move(lhs.append(rhs));
+}
+
+inline string operator+ (const string &lhs, const char *rhs) {
+    size_t n = strlen(rhs);
+    string result;
+    result.reserve(lhs.size() + n);
+    result.append(lhs).append(rhs, n);
+    return result;
+}
+
+inline string operator+ (string &&lhs, const char *rhs) {
+    return ministl::move(lhs.append(rhs));
+}
+
+inline void swap(string &lhs, string &rhs) noexcept {
+    lhs.swap(rhs);
 }
 
-std::pair<char *, char *> string::alloc_n_copy (const char * beg, const char * end) {
-    auto newstr = alloc.allocate(end - beg);
-    return {newstr, std::uninitialized_copy(beg, end, newstr)};
+inline std::ostream& operator<< (std::ostream& os, const string& s) {
+    return os.write(s.data(), s.size());
 }
 
 }
 
 
-#endif //MINISTL_STRING_H
\ No newline at end of file
+#endif //MINISTL_STRING_H
@@ -0,0 +1,217 @@
+#ifndef MINISTL_STRING_SEARCH_H
+#define MINISTL_STRING_SEARCH_H
+
+#include <cstddef>
+#include <cstring>      // for memcmp
+
+/**
+ * 字符串查找的内核，供 string_view 和 string 使用
+ *     _find_char(p, n, c)             [p, p+n) 中第一个 c
+ *     _rfind_char(p, n, c)            [p, p+n) 中最后一个 c
+ *     _find_first_of(p, n, s, m)      [p, p+n) 中第一个属于 [s, s+m) 的字符
+ *     _find_substr(p, n, s, m)        [p, p+n) 中第一次出现 [s, s+m) 的位置，m 不小于 2
+ * 都返回指向找到的字符的指针，找不到时返回 nullptr
+ *
+ * x86 上用 SSE2 每次比较 16 个字节，CPU 支持 AVX2 时 _find_char 和 _find_first_of 每次比较 32 个字节
+ * 第一次调用时用 __builtin_cpu_supports 选择内核，之后通过函数指针调用，不需要用 -mavx2 编译
+ * 子串查找同时比较子串首字节和尾字节所在的两个块，两者都匹配的位置才用 memcmp 比较中间的字节
+ * 所有的加载都不越过 [p, p+n)，末尾不足一个块时与前一个块重叠
+ * 其他平台或定义了 MINISTL_NO_SIMD 时使用逐字节的版本
+ */
+
+#if (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))) \
+    && defined(__GNUC__) && !defined(MINISTL_NO_SIMD)
+#define _MINISTL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace ministl {
+
+inline const char * _find_char_scalar(const char *p, size_t n, char c) {
+    for (size_t i = 0; i < n; ++i)
+        if (p[i] == c) return p + i;
+    return nullptr;
+}
+
+inline const char * _rfind_char_scalar(const char *p, size_t n, char c) {
+    while (n-- > 0)
+        if (p[n] == c) return p + n;
+    return nullptr;
+}
+
+// 字符集较大时使用 256 位的表
+inline const char * _find_first_of_scalar(const char *p, size_t n, const char *s, size_t m) {
+    unsigned char table[256] = { 0 };
+    for (size_t j = 0; j < m; ++j) table[(unsigned char) s[j]] = 1;
+    for (size_t i = 0; i < n; ++i)
+        if (table[(unsigned char) p[i]]) return p + i;
+    return nullptr;
+}
+
+inline const char * _find_substr_scalar(const char *p, size_t n, const char *s, size_t m) {
+    if (m > n) return nullptr;
+    for (size_t i = 0; i + m <= n; ++i)
+        if (p[i] == s[0] && p[i + m - 1] == s[m - 1] && 0 == memcmp(p + i + 1, s + 1, m - 2))
+            return p + i;
+    return nullptr;
+}
+
+#ifdef _MINISTL_SIMD_X86
+
+// 第一个块之后，末尾的块与前一个块重叠，mask 右移去掉已经比较过的字节
+inline const char * _find_char_sse2(const char *p, size_t n, char c) {
+    if (n < 16) return _find_char_scalar(p, n, c);
+    const __m128i v = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + i)), v));
+        if (mask) return p + i + __builtin_ctz(mask);
+    }
+    if (i < n) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + n - 16)), v));
+        mask >>= i - (n - 16);
+        if (mask) return p + i + __builtin_ctz(mask);
+    }
+    return nullptr;
+}
+
+__attribute__((target("avx2")))
+inline const char * _find_char_avx2(const char *p, size_t n, char c) {
+    if (n < 32) return _find_char_sse2(p, n, c);
+    const __m256i v = _mm256_set1_epi8(c);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + i)), v));
+        if (mask) return p + i + __builtin_ctz(mask);
+    }
+    if (i < n) {
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (p + n - 32)), v));
+        mask >>= i - (n - 32);
+        if (mask) return p + i + __builtin_ctz(mask);
+    }
+    return nullptr;
+}
+
+// 从末尾向前，开头不足一个块时与后一个块重叠，只保留 [0, i) 的字节
+inline const char * _rfind_char_sse2(const char *p, size_t n, char c) {
+    if (n < 16) return _rfind_char_scalar(p, n, c);
+    const __m128i v = _mm_set1_epi8(c);
+    size_t i = n;
+    for (; i >= 16; i -= 16) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (p + i - 16)), v));
+        if (mask) return p + i - 16 + (31 - __builtin_clz(mask));
+    }
+    if (i > 0) {
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), v));
+        mask &= (1u << i) - 1;
+        if (mask) return p + (31 - __builtin_clz(mask));
+    }
+    return nullptr;
+}
+
+// 字符集不超过 16 个字符时，每个块与每个字符比较一次，结果按位或
+static const size_t _FIND_FIRST_OF_SIMD_MAX = 16;
+
+inline const char * _find_first_of_sse2(const char *p, size_t n, const char *s, size_t m) {
+    if (n < 16 || m > _FIND_FIRST_OF_SIMD_MAX) return _find_first_of_scalar(p, n, s, m);
+    __m128i set[_FIND_FIRST_OF_SIMD_MAX];
+    for (size_t j = 0; j < m; ++j) set[j] = _mm_set1_epi8(s[j]);
+    size_t i = 0;
+    for (;;) {
+        size_t b = i + 16 <= n ? i : n - 16;
+        const __m128i x = _mm_loadu_si128((const __m128i *) (p + b));
+        __m128i eq = _mm_setzero_si128();
+        for (size_t j = 0; j < m; ++j) eq = _mm_or_si128(eq, _mm_cmpeq_epi8(x, set[j]));
+        unsigned mask = _mm_movemask_epi8(eq) >> (i - b);
+        if (mask) return p + i + __builtin_ctz(mask);
+        i += 16 - (i - b);
+        if (i >= n) return nullptr;
+    }
+}
+
+__attribute__((target("avx2")))
+inline const char * _find_first_of_avx2(const char *p, size_t n, const char *s, size_t m) {
+    if (n < 32 || m > _FIND_FIRST_OF_SIMD_MAX) return _find_first_of_sse2(p, n, s, m);
+    __m256i set[_FIND_FIRST_OF_SIMD_MAX];
+    for (size_t j = 0; j < m; ++j) set[j] = _mm256_set1_epi8(s[j]);
+    size_t i = 0;
+    for (;;) {
+        size_t b = i + 32 <= n ? i : n - 32;
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (p + b));
+        __m256i eq = _mm256_setzero_si256();
+        for (size_t j = 0; j < m; ++j) eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(x, set[j]));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(eq) >> (i - b);
+        if (mask) return p + i + __builtin_ctz(mask);
+        i += 32 - (i - b);
+        if (i >= n) return nullptr;
+    }
+}
+
+// 候选位置 i 需要 p[i] == s[0] 且 p[i + m - 1] == s[m - 1]，一次检查 16 个候选位置
+inline const char * _find_substr_sse2(const char *p, size_t n, const char *s, size_t m) {
+    if (m > n) return nullptr;
+    const __m128i first = _mm_set1_epi8(s[0]);
+    const __m128i last = _mm_set1_epi8(s[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        const __m128i bf = _mm_loadu_si128((const __m128i *) (p + i));
+        const __m128i bl = _mm_loadu_si128((const __m128i *) (p + i + m - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, last)));
+        while (mask) {
+            unsigned bit = __builtin_ctz(mask);
+            if (0 == memcmp(p + i + bit + 1, s + 1, m - 2)) return p + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return _find_substr_scalar(p + i, n - i, s, m);
+}
+
+typedef const char * (*_find_char_fn)(const char *, size_t, char);
+typedef const char * (*_find_first_of_fn)(const char *, size_t, const char *, size_t);
+
+inline bool _cpu_has_avx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+inline const char * _find_char(const char *p, size_t n, char c) {
+    static const _find_char_fn fn = _cpu_has_avx2() ? _find_char_avx2 : _find_char_sse2;
+    return fn(p, n, c);
+}
+
+inline const char * _rfind_char(const char *p, size_t n, char c) {
+    return _rfind_char_sse2(p, n, c);
+}
+
+inline const char * _find_first_of(const char *p, size_t n, const char *s, size_t m) {
+    static const _find_first_of_fn fn = _cpu_has_avx2() ? _find_first_of_avx2 : _find_first_of_sse2;
+    return fn(p, n, s, m);
+}
+
+inline const char * _find_substr(const char *p, size_t n, const char *s, size_t m) {
+    return _find_substr_sse2(p, n, s, m);
+}
+
+#else
+
+inline const char * _find_char(const char *p, size_t n, char c) {
+    return _find_char_scalar(p, n, c);
+}
+
+inline const char * _rfind_char(const char *p, size_t n, char c) {
+    return _rfind_char_scalar(p, n, c);
+}
+
+inline const char * _find_first_of(const char *p, size_t n, const char *s, size_t m) {
+    return _find_first_of_scalar(p, n, s, m);
+}
+
+inline const char * _find_substr(const char *p, size_t n, const char *s, size_t m) {
+    return _find_substr_scalar(p, n, s, m);
+}
+
+#endif // _MINISTL_SIMD_X86
+
+}
+
+#endif // MINISTL_STRING_SEARCH_H
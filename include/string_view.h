@@ -0,0 +1,175 @@
+#ifndef MINISTL_STRING_VIEW_H
+#define MINISTL_STRING_VIEW_H
+
+#include <cstddef>
+#include <cstring>      // for memcmp, strlen
+#include <iostream>
+#include <stdexcept>    // for out_of_range, invalid_argument
+#include "string_search.h"
+#include "vector.h"
+
+namespace ministl {
+
+/**
+ * 不拥有内存的字符串片段 { 指针, 长度 }
+ * 只引用别处的字符，复制和 substr 都不分配内存，也不保证以 '\0' 结尾
+ * 被引用的字符串修改或析构之后，view 随之失效
+ * string 可以隐式转换为 string_view，函数参数写成 string_view 时 string 和 C 字符串都可以传入
+ */
+class string_view {
+
+public:
+    typedef char            value_type;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef const char&     reference;
+    typedef const char&     const_reference;
+    typedef const char*     pointer;
+    typedef const char*     const_pointer;
+    typedef const char*     iterator;
+    typedef const char*     const_iterator;
+
+    static const size_type npos = size_type(-1);
+
+    string_view() : ptr(nullptr), len(0) { }
+    string_view(const char *s) : ptr(s), len(strlen(s)) { }
+    string_view(const char *s, size_type n) : ptr(s), len(n) { }
+
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + len; }
+
+    size_type size() const { return len; }
+    size_type length() const { return len; }
+    bool empty() const { return 0 == len; }
+    const char * data() const { return ptr; }
+
+    const_reference operator[](size_type n) const { return ptr[n]; }
+    const_reference front() const { return ptr[0]; }
+    const_reference back() const { return ptr[len - 1]; }
+
+    void remove_prefix(size_type n) { ptr += n; len -= n; }
+    void remove_suffix(size_type n) { len -= n; }
+
+    // 从 pos 开始的至多 n 个字符，pos 超出末尾时抛出 out_of_range
+    string_view substr(size_type pos = 0, size_type n = npos) const {
+        if (pos > len) throw std::out_of_range("ministl::string_view");
+        return string_view(ptr + pos, n < len - pos ? n : len - pos);
+    }
+
+    // 按无符号字节比较，返回值的符号与 memcmp 相同
+    // libc 的 memcmp 已经按 CPU 选择了 SSE2 / AVX2 的实现，这里不再另写内核
+    int compare(string_view s) const {
+        size_type n = len < s.len ? len : s.len;
+        int r = n ? memcmp(ptr, s.ptr, n) : 0;
+        if (r != 0) return r;
+        return len < s.len ? -1 : (len > s.len ? 1 : 0);
+    }
+
+    bool starts_with(string_view s) const {
+        return len >= s.len && 0 == memcmp(ptr, s.ptr, s.len);
+    }
+    bool ends_with(string_view s) const {
+        return len >= s.len && 0 == memcmp(ptr + len - s.len, s.ptr, s.len);
+    }
+
+    // 查找都由 string_search.h 中的 SIMD 内核完成，找不到时返回 npos
+    size_type find(char c, size_type pos = 0) const {
+        if (pos >= len) return npos;
+        return to_pos(_find_char(ptr + pos, len - pos, c));
+    }
+
+    size_type find(string_view s, size_type pos = 0) const {
+        if (pos > len || s.len > len - pos) return npos;
+        if (s.len <= 1) return s.empty() ? pos : find(s.ptr[0], pos);
+        return to_pos(_find_substr(ptr + pos, len - pos, s.ptr, s.len));
+    }
+
+    // 最后一个不晚于 pos 的位置
+    size_type rfind(char c, size_type pos = npos) const {
+        if (0 == len) return npos;
+        return to_pos(_rfind_char(ptr, pos < len ? pos + 1 : len, c));
+    }
+
+    size_type rfind(string_view s, size_type pos = npos) const {
+        if (s.len > len) return npos;
+        size_type i = len - s.len < pos ? len - s.len : pos;
+        if (s.empty()) return i;
+        // 从后向前用 s 的首字符定位候选位置
+        for (;;) {
+            size_type j = rfind(s.ptr[0], i);
+            if (j == npos) return npos;
+            if (0 == memcmp(ptr + j + 1, s.ptr + 1, s.len - 1)) return j;
+            if (0 == j) return npos;
+            i = j - 1;
+        }
+    }
+
+    size_type find_first_of(string_view s, size_type pos = 0) const {
+        if (pos >= len) return npos;
+        return to_pos(_find_first_of(ptr + pos, len - pos, s.ptr, s.len));
+    }
+
+private:
+    const char *ptr;
+    size_type len;
+
+    size_type to_pos(const char *p) const { return p ? p - ptr : npos; }
+};
+
+inline bool operator== (string_view lhs, string_view rhs) {
+    return lhs.size() == rhs.size() && 0 == lhs.compare(rhs);
+}
+inline bool operator!= (string_view lhs, string_view rhs) { return !(lhs == rhs); }
+inline bool operator< (string_view lhs, string_view rhs) { return lhs.compare(rhs) < 0; }
+inline bool operator> (string_view lhs, string_view rhs) { return rhs < lhs; }
+inline bool operator<= (string_view lhs, string_view rhs) { return !(rhs < lhs); }
+inline bool operator>= (string_view lhs, string_view rhs) { return !(lhs < rhs); }
+
+inline std::ostream& operator<< (std::ostream& os, string_view s) {
+    return os.write(s.data(), s.size());
+}
+
+/**
+ * 按分隔符切分 s，结果追加到 out 中，每一项都是 s 所引用的字符串的片段
+ * 相邻的分隔符之间得到空的片段，与 Python 的 str.split(sep) 相同
+ * 解析大量的行时复用同一个 out (先 clear)，每一行都不分配内存
+ */
+template <typename Alloc, typename Growth>
+void split(string_view s, char delim, vector<string_view, Alloc, Growth>& out) {
+    for (;;) {
+        string_view::size_type pos = s.find(delim);
+        if (pos == string_view::npos) break;
+        out.push_back(s.substr(0, pos));
+        s.remove_prefix(pos + 1);
+    }
+    out.push_back(s);
+}
+
+// delim 为空时抛出 invalid_argument，与 Python 的 str.split('') 相同
+template <typename Alloc, typename Growth>
+void split(string_view s, string_view delim, vector<string_view, Alloc, Growth>& out) {
+    if (delim.empty()) throw std::invalid_argument("ministl::split: empty delimiter");
+    for (;;) {
+        string_view::size_type pos = s.find(delim);
+        if (pos == string_view::npos) break;
+        out.push_back(s.substr(0, pos));
+        s.remove_prefix(pos + delim.size());
+    }
+    out.push_back(s);
+}
+
+inline vector<string_view> split(string_view s, char delim) {
+    vector<string_view> out;
+    split(s, delim, out);
+    return out;
+}
+
+inline vector<string_view> split(string_view s, string_view delim) {
+    vector<string_view> out;
+    split(s, delim, out);
+    return out;
+}
+
+}
+
+#endif // MINISTL_STRING_VIEW_H
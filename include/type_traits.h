@@ -3,10 +3,23 @@
 #ifndef MINISTL_TYPE_TRAITS_H
 #define MINISTL_TYPE_TRAITS_H
 
+#include <type_traits>      // for std::is_trivially_copyable, is_integral
+
 namespace ministl {
 
-struct true_type { };
-struct false_type { };
+struct true_type { static const bool value = true; };
+struct false_type { static const bool value = false; };
+
+// 将编译期的 bool 值转为 true_type 或 false_type，用于重载选择
+template <bool B>
+struct bool_type {
+    typedef false_type type;
+};
+
+template <>
+struct bool_type<true> {
+    typedef true_type type;
+};
 
 template <typename T>
 struct type_traits {
@@ -152,6 +165,30 @@ struct type_traits<T*> {
     typedef true_type    is_POD_type;
 };
 
+/**
+ * 可以平凡重定位的类型：把对象按字节复制到新地址，并且不对旧地址调用析构函数，
+ * 结果等同于在新地址移动构造再析构旧对象
+ * 这样的元素可以随 realloc / mremap 一起搬移，vector 扩容时不需要逐个移动
+ * 平凡可复制的类型都满足，只持有自身之外资源的类型 (例如只有一个堆指针的句柄) 通常也满足，
+ * 可以特化为 true_type 加入：
+ *     namespace ministl {
+ *     template <> struct is_trivially_relocatable<my_handle> : true_type { };
+ *     }
+ * 持有指向自身的指针的类型 (例如 SSO 的 std::string) 不满足
+ */
+template <typename T>
+struct is_trivially_relocatable : bool_type<std::is_trivially_copyable<T>::value>::type { };
+
+/**
+ * 按字节比较与按值比较结果相同的类型：整数、字符、bool、指针和枚举
+ * 相等比较可以直接用 memcmp，见 algo.h 中的 equal 和 lexicographical_compare
+ * 浮点数不满足 (0.0 == -0.0，NaN != NaN)，有填充字节的结构体也不满足
+ */
+template <typename T>
+struct is_trivially_comparable
+    : bool_type<std::is_integral<T>::value || std::is_pointer<T>::value
+                || std::is_enum<T>::value>::type { };
+
 }
 
 #endif // MINISTL_TYPE_TRAITS_H
\ No newline at end of file
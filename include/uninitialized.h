@@ -6,6 +6,8 @@
 #include "allocator.h"
 #include "type_traits.h"
 #include "algo.h"
+#include "util.h"       // for move
+#include <type_traits>  // for is_nothrow_move_constructible
 
 namespace ministl {
 
@@ -16,28 +18,12 @@ namespace ministl {
  * 对于有 trivial constructor 的类型，调用 fill_n 函数，即每个元素直接使用 = 赋值
  * 对于 non-trivail constructor 的类型，调用 construct(p, value) 
  */
-template <typename ForwardIterator, typename Size, typename T>
-inline ForwardIterator uninitialized_fill_n(ForwardIterator first,
-                                            Size n, const T& x) {
-    // value_type 萃取出 first 的类型，为 T*
-    return _uninitialized_fill_n(first, n, x, value_type(first));
-}
-
-template <typename ForwardIterator, typename Size, typename T, typename T1>
-inline ForwardIterator _uninitialized_fill_n(ForwardIterator first,
-                                             Size n, const T& x, T1*) {
-    // POD, Plain Old Data, 标量型别或传统的 C struct 型别
-    // POD 型别必然拥有 trivial ctor/dtor/copy/assignment 函数
-    typedef typename type_traits<T1>::is_POD_type is_POD;
-    return _uninitialized_fill_n_aux(first, n, x, is_POD());
-}
-
 // 如果是 POD 型别，则直接转为调用 fill_n() 函数
 template <typename ForwardIterator, typename Size, typename T>
 inline ForwardIterator
 _uninitialized_fill_n_aux(ForwardIterator first, 
-                          Size n, const T* x, ministl::true_type) {
-    return fill_n(first, n, x);
+                          Size n, const T& x, ministl::true_type) {
+    return ministl::fill_n(first, n, x);
 }
 
 // 如果不是 POD 型别，需要调用 constructor 来一个一个构造
@@ -45,49 +31,48 @@ _uninitialized_fill_n_aux(ForwardIterator first,
 template <typename ForwardIterator, typename Size, typename T>
 inline ForwardIterator
 _uninitialized_fill_n_aux(ForwardIterator first, 
-                          Size n, const T* x, ministl::false_type) {
+                          Size n, const T& x, ministl::false_type) {
     ForwardIterator cur = first;
     try {
         for ( ; n > 0; --n, ++cur) {
             // 因为 cur 是迭代器，所以 *cur 得到 T, 再 &T 得到 T*
-            construct(&*cur, x);
+            ministl::construct(&*cur, x);
         }
         return cur;
     } catch (...) {
-        destroy(first, cur);
+        ministl::destroy(first, cur);
         throw;
     }
 }
 
+template <typename ForwardIterator, typename Size, typename T, typename T1>
+inline ForwardIterator _uninitialized_fill_n(ForwardIterator first,
+                                             Size n, const T& x, T1*) {
+    // POD, Plain Old Data, 标量型别或传统的 C struct 型别
+    // POD 型别必然拥有 trivial ctor/dtor/copy/assignment 函数
+    typedef typename type_traits<T1>::is_POD_type is_POD;
+    return _uninitialized_fill_n_aux(first, n, x, is_POD());
+}
+
+template <typename ForwardIterator, typename Size, typename T>
+inline ForwardIterator uninitialized_fill_n(ForwardIterator first,
+                                            Size n, const T& x) {
+    // value_type 萃取出 first 的类型，为 T*
+    return _uninitialized_fill_n(first, n, x, value_type(first));
+}
+
 /**
  * uninitialized_copy 函数
  * 在迭代器 [result, result+(last-first)) 之间使用 [first, last) 中的元素初始化
  * 即调用复制构造函数复制 [first, last) 中的元素到 [result, result+(last-first)) 中
  * result 所指向的内存空间已经分配过了 
  */
-template <typename InputIterator, typename ForwardIterator>
-inline ForwardIterator 
-uninitialized_copy(InputIterator first, InputIterator last, 
-                   ForwardIterator result) {
-    // 这里萃取的 result 的类型，因为要在 result 中构造相对应的对象
-    return _uninitialized_copy(firs, last, result, value_type(result));
-}
-
-// 根据萃取得到的类型，判断是否该类型是否是 POD
-template <typename InputIterator, typename ForwardIterator, typename T>
-inline ForwardIterator
-_uninitialized_copy(InputIterator first, InputIterator last, 
-                    ForwardIterator result, T*) {
-    typedef typename type_traits<T>::is_POD_type is_POD;
-    return _uninitialized_copy_aux(first, last, result, is_POD());
-}
-
 // 是 POD, 调用算法文件中的 copy 函数
 template <typename InputIterator, typename ForwardIterator>
 inline ForwardIterator
 _uninitialized_copy_aux(InputIterator first, InputIterator last, 
                         ForwardIterator result, ministl::true_type) {
-    return copy(first, last, result);
+    return ministl::copy(first, last, result);
 }
 
 // 不是 POD, 使用construct 构造对象， commit or rollback
@@ -98,15 +83,32 @@ _uninitialized_copy_aux(InputIterator first, InputIterator last,
     ForwardIterator cur = result;
     try {
         for (; first != last; ++first, ++cur) {
-            construct(&*cur, *first);
+            ministl::construct(&*cur, *first);
         }
         return cur;
     } catch (...) {
-        destroy(result, cur);
+        ministl::destroy(result, cur);
         throw;
     }
 }
 
+// 根据萃取得到的类型，判断是否该类型是否是 POD
+template <typename InputIterator, typename ForwardIterator, typename T>
+inline ForwardIterator
+_uninitialized_copy(InputIterator first, InputIterator last, 
+                    ForwardIterator result, T*) {
+    typedef typename type_traits<T>::is_POD_type is_POD;
+    return _uninitialized_copy_aux(first, last, result, is_POD());
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator 
+uninitialized_copy(InputIterator first, InputIterator last, 
+                   ForwardIterator result) {
+    // 这里萃取的 result 的类型，因为要在 result 中构造相对应的对象
+    return _uninitialized_copy(first, last, result, value_type(result));
+}
+
 // 针对 const char* 的特化版本，因为 memmove 的效率很高
 inline char* uninitialized_copy(const char *first, const char *last, 
                                 char *result) {
@@ -117,10 +119,66 @@ inline char* uninitialized_copy(const char *first, const char *last,
 // 针对 const wchar_t* 的特化版本
 inline wchar_t* uninitialized_copy(const wchar_t *first, const wchar_t *last, 
                                    wchar_t *result) {
-    memmove(result, first, last - first);
+    memmove(result, first, sizeof(wchar_t) * (last - first));
     return result + (last - first);
 }
 
+/**
+ * uninitialized_move_if_noexcept 函数
+ * 与 uninitialized_copy 相同，但元素的移动构造函数不会抛出异常 (或者元素不能复制) 时使用移动构造
+ * vector 扩容时用它搬移元素：移动构造抛出异常时原来的元素已经被破坏，无法恢复
+ * 所以只有 noexcept 的移动构造才能代替复制构造，同时保持 commit or rollback
+ * POD 型别直接使用 uninitialized_copy (memmove)
+ */
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator
+_uninitialized_move_nothrow(InputIterator first, InputIterator last,
+                            ForwardIterator result, ministl::true_type) {
+    ForwardIterator cur = result;
+    try {
+        for (; first != last; ++first, ++cur) {
+            ministl::construct(&*cur, ministl::move(*first));
+        }
+        return cur;
+    } catch (...) {
+        ministl::destroy(result, cur);
+        throw;
+    }
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+_uninitialized_move_nothrow(InputIterator first, InputIterator last,
+                            ForwardIterator result, ministl::false_type) {
+    return ministl::uninitialized_copy(first, last, result);
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+_uninitialized_move_aux(InputIterator first, InputIterator last,
+                        ForwardIterator result, ministl::true_type) {
+    return ministl::uninitialized_copy(first, last, result);
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+_uninitialized_move_aux(InputIterator first, InputIterator last,
+                        ForwardIterator result, ministl::false_type) {
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename bool_type<std::is_nothrow_move_constructible<T>::value
+                               || !std::is_copy_constructible<T>::value>::type use_move;
+    return _uninitialized_move_nothrow(first, last, result, use_move());
+}
+
+template <typename InputIterator, typename ForwardIterator>
+inline ForwardIterator
+uninitialized_move_if_noexcept(InputIterator first, InputIterator last,
+                               ForwardIterator result) {
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename type_traits<T>::is_POD_type is_POD;
+    return _uninitialized_move_aux(first, last, result, is_POD());
+}
+
 /**
  * uninitialized_fill 函数
  * 对于 [first, last) 之间的内存空间使用 x 进行 copy constructor
@@ -128,42 +186,81 @@ inline wchar_t* uninitialized_copy(const wchar_t *first, const wchar_t *last,
  */
 template <typename ForwardIterator, typename T>
 ForwardIterator
-uninitialized_fill(ForwardIterator first, ForwardIterator last, 
-                   const T& x) {
-    _uninitialized_fill(first, last, x, value_type(first));
-} 
+_uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, 
+                        const T& x, ministl::true_type) {
+    ministl::fill(first, last, x);
+    return last;
+}
+
+template <typename ForwardIterator, typename T>
+ForwardIterator
+_uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, 
+                        const T& x, ministl::false_type) {
+    ForwardIterator cur = first;
+    try {
+        for (; cur != last; ++cur) {
+            ministl::construct(&*cur, x);
+        }
+        return cur;
+    } catch (...) {
+        ministl::destroy(first, cur);
+        throw;
+    }
+}
 
 template <typename ForwardIterator, typename T, typename T1>
 ForwardIterator
 _uninitialized_fill(ForwardIterator first, ForwardIterator last, 
                     const T& x, T1*) {
     typedef typename type_traits<T1>::is_POD_type is_POD;
-    _uninitialized_fill_aux(first, last, x, is_POD());
+    return _uninitialized_fill_aux(first, last, x, is_POD());
 }
 
 template <typename ForwardIterator, typename T>
 ForwardIterator
-_uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, 
-                        const T& x, ministl::true_type) {
-    fill(first, last, x);
+uninitialized_fill(ForwardIterator first, ForwardIterator last, 
+                   const T& x) {
+    return _uninitialized_fill(first, last, x, value_type(first));
 }
 
-template <typename ForwardIterator, typename T>
-ForwardIterator
-_uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, 
-                        const T& x, ministl::false_type) {
+/**
+ * uninitialized_default_n 函数
+ * 对 [first, first+n) 进行默认初始化，即 new (p) T，而不是 new (p) T() 的值初始化
+ * 对于有 trivial default constructor 的类型什么也不做，内存保持原来的内容
+ * 用于马上会被覆盖的缓冲区，例如从文件或 socket 读入数据之前，避免多余的清零
+ */
+template <typename ForwardIterator, typename Size>
+inline ForwardIterator
+_uninitialized_default_n_aux(ForwardIterator first, Size n, ministl::true_type) {
+    ministl::advance(first, n);
+    return first;
+}
+
+template <typename ForwardIterator, typename Size>
+inline ForwardIterator
+_uninitialized_default_n_aux(ForwardIterator first, Size n, ministl::false_type) {
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
     ForwardIterator cur = first;
     try {
-        for (; cur != last; ++cur) {
-            construct(&*cur, x);
-        }
+        for ( ; n > 0; --n, ++cur)
+            ::new ((void *) &*cur) T;
         return cur;
-    } catch {
-        destroy(first, cur);
+    } catch (...) {
+        ministl::destroy(first, cur);
         throw;
     }
 }
 
+template <typename ForwardIterator, typename Size>
+inline ForwardIterator uninitialized_default_n(ForwardIterator first, Size n) {
+    typedef typename iterator_traits<ForwardIterator>::value_type T;
+    typedef typename type_traits<T>::has_trivial_default_constructor trivial_ctor;
+    return _uninitialized_default_n_aux(first, n, trivial_ctor());
+}
+
+// 作为构造函数的参数，表示新元素默认初始化，见 uninitialized_default_n
+struct default_init_t { };
+static const default_init_t default_init = default_init_t();
 
 }
 
@@ -26,10 +26,25 @@ namespace ministl {
  * 从一个左值 static_cast 到一个右值引用时允许的
  */
 template <typename T>
-typename std::remove_reference<T>::type move(T&& t) noexcept {
+typename std::remove_reference<T>::type&& move(T&& t) noexcept {
     return static_cast<typename std::remove_reference<T>::type&&> (t);
 }
 
+/**
+ * forward 函数，完美转发
+ * 模板参数 T 由 Args&& 推导得到：实参是左值时 T 为 X&，是右值时 T 为 X
+ * 再经过引用折叠，左值转发为左值引用，右值转发为右值引用
+ */
+template <typename T>
+T&& forward(typename std::remove_reference<T>::type& t) noexcept {
+    return static_cast<T&&>(t);
+}
+
+template <typename T>
+T&& forward(typename std::remove_reference<T>::type&& t) noexcept {
+    return static_cast<T&&>(t);
+}
+
 
 
 
@@ -1,16 +1,29 @@
-
 #ifndef MINISTL_VECTOR_H
 #define MINISTL_VECTOR_H
 
 #include <cstddef>
+#include <cstring>          // for memmove
 #include "allocator.h"
+#include "growth_policy.h"
 #include "uninitialized.h"
 #include "algo.h"
 
 namespace ministl {
 
-template<typename T, typename Alloc = ministl::allocator<T>>
-class vector {
+// 定义在 parallel.h 中，使用 vector 的并行构造和 resize 时需要包含 parallel.h
+struct parallel_t;
+
+/**
+ * vector 与 small_vector 共用的部分：元素的插入、删除和扩容
+ * 元素保存在 [start, finish)，容量到 end_of_storage 为止
+ * 空间的归还和原地扩展由 Derived 决定 (CRTP)，Derived 可以重新定义：
+ *     void deallocate()                     归还 [start, end_of_storage)
+ *     iterator reallocate_block(size_type)  把空间调整为 len 个元素并返回新的 start，
+ *                                           只用于可以平凡重定位的 T，见 use_reallocate
+ * 构造、析构、赋值和 swap 由 Derived 实现
+ */
+template <typename T, typename Alloc, typename Growth, typename Derived>
+class _vector_base {
 public:
     typedef T                   value_type;
     typedef value_type*         pointer;
@@ -22,6 +35,7 @@ public:
     typedef size_t              size_type;
     typedef ptrdiff_t           difference_type;
     typedef Alloc               allocator_type;
+    typedef Growth              growth_policy;
     allocator_type get_allocator() const { return data_allocator; }
 
 protected:
@@ -30,78 +44,156 @@ protected:
     iterator        finish;            // 表示目前使用空间的尾
     iterator        end_of_storage;    // 表示目前可用空间的尾
 
-    void insert_aux(iterator position, const T& x);
+    _vector_base() : start(nullptr), finish(nullptr), end_of_storage(nullptr) { }
+    explicit _vector_base(const allocator_type& a)
+        : data_allocator(a), start(nullptr), finish(nullptr), end_of_storage(nullptr) { }
+
+    Derived& self() { return static_cast<Derived&>(*this); }
 
     void deallocate() {
         if (start)
             data_allocator.deallocate(start, end_of_storage - start);
     }
 
+    iterator reallocate_block(size_type len) {
+        return data_allocator.reallocate(start, end_of_storage - start, len);
+    }
+
+    // 在 position 处用 args 构造一个元素，空间不足时扩容
+    template <typename ... Args>
+    void insert_aux(iterator position, Args&& ... args);
+
+    /**
+     * 扩容的两种方式
+     * T 可以平凡重定位并且配置器提供 reallocate 时，整块空间交给 reallocate，
+     * 大区块由 realloc / mremap 原地扩展或移动页面，元素不需要逐个移动和析构
+     * 否则分配新空间，用 uninitialized_move_if_noexcept 逐个移动 (或复制) 原有元素
+     */
+    struct use_reallocate : bool_type<is_trivially_relocatable<T>::value
+                                      && has_reallocate<Alloc, T*>::value>::type { };
+
+    template <typename ... Args>
+    void realloc_insert(true_type, size_type len, iterator position, Args&& ... args);
+    template <typename ... Args>
+    void realloc_insert(false_type, size_type len, iterator position, Args&& ... args);
+
+    void realloc_fill_insert(iterator position, size_type n, const T& x, size_type len, true_type);
+    void realloc_fill_insert(iterator position, size_type n, const T& x, size_type len, false_type);
+
+    void realloc_range_insert(iterator position, const_iterator first, const_iterator last,
+                              size_type len, true_type);
+    void realloc_range_insert(iterator position, const_iterator first, const_iterator last,
+                              size_type len, false_type);
+
+    // reallocate 到 len 个元素的空间，position 之后的元素后移 n 个位置，返回空出的第一个位置
+    // 空位中的元素构造好之前 finish 不变
+    iterator reallocate_gap(iterator position, size_type n, size_type len) {
+        const size_type elems_before = position - start;
+        const size_type elems_after = finish - position;
+        start = self().reallocate_block(len);
+        finish = start + elems_before + elems_after;
+        end_of_storage = start + len;
+        position = start + elems_before;
+        if (0 != elems_after)
+            memmove((void *) (position + n), (const void *) position, elems_after * sizeof(T));
+        return position;
+    }
+
+    // 至少需要容纳 required 个元素时的新容量
+    size_type next_capacity(size_type required) const {
+        return Growth::template next_capacity<allocator_type>(capacity(), required, sizeof(T));
+    }
+
+    // 把容量改为 len，len 不小于 size()
+    void reallocate_storage(size_type len, true_type) {
+        reallocate_gap(finish, 0, len);
+    }
+
+    void reallocate_storage(size_type len, false_type) {
+        iterator new_start = data_allocator.allocate(len);
+        iterator new_finish;
+        try {
+            new_finish = ministl::uninitialized_move_if_noexcept(start, finish, new_start);
+        }
+        catch (...) {
+            data_allocator.deallocate(new_start, len);
+            throw;
+        }
+        ministl::destroy(start, finish);
+        self().deallocate();
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
+    }
+
+    // 分配 len 个元素的新空间，原有元素逐个移动过去，然后归还原来的空间
+    // 新空间中的元素 [new_start, new_finish) 已经构造好
+    void replace_storage(iterator new_start, iterator new_finish, size_type len) {
+        ministl::destroy(start, finish);
+        self().deallocate();
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = new_start + len;
+    }
+
+    // 空位中的元素构造失败时，把后移的元素搬回去
+    void close_gap(iterator position, size_type n) {
+        if (finish != position)
+            memmove((void *) position, (const void *) (position + n), (finish - position) * sizeof(T));
+    }
+
     iterator allocate_and_fill(size_type n, const T& x) {
         iterator result = data_allocator.allocate(n);
-        uninitialized_fill_n(result, n, x);
-        return result;
+        try {
+            ministl::uninitialized_fill_n(result, n, x);
+            return result;
+        }
+        catch (...) {
+            data_allocator.deallocate(result, n);
+            throw;
+        }
     }
 
     iterator allocate_and_copy(size_type n, const_iterator first,
                                             const_iterator last) {
         iterator result = data_allocator.allocate(n);
         try {
-            uninitialized_copy(first, last, result);
+            ministl::uninitialized_copy(first, last, result);
             return result;
         }
-        catch {
+        catch (...) {
             data_allocator.deallocate(result, n);
-            throw();
+            throw;
         }
     }
 
-    void fill_initialize(size_type n, const T& value) {
-        start = allocate_and_fill(n, value);
-        finish = start + n;
-        end_of_storage = finish;
-    }
+    // 复制赋值，容量不足时先在新空间中复制好再归还原来的空间
+    void assign_copy(const_iterator first, const_iterator last);
 
-public: 
+public:
     iterator begin() { return start; }
     const_iterator begin() const { return start; }
     iterator end() { return finish; }
     const_iterator end() const { return finish; }
 
-    size_type size() const 
+    size_type size() const
         { return size_type(end() - begin()); }
     size_type max_size() const
         { return size_type(-1) / sizeof(T); }
-    size_type capacity() const 
+    size_type capacity() const
         { return size_type(end_of_storage - begin()); }
-    bool empty() const 
+    bool empty() const
         { return begin() == end(); }
-    
-    reference operator[](size_type n) 
-        { return *(begin() + n); }
-    const_reference operator[](size_type n) const 
-        { return *(begin() + n); }
 
-    vector() : start(nullptr), finish(nullptr), end_of_storage(nullptr) { }
-    vector(size_type n, const T& value) 
-        { fill_initialize(n, value); }
-    explicit vector( size_type n ) 
-        { fill_initialize(n, T()); }
-    vector(const vector<T, Alloc>& x) : data_allocator(x.get_allocator()) {
-        fill_initialize(x.size());
-        finish = uninitialized_copy(x.begin(), x.end(), start);
+    // 容量至少为 n，元素不变
+    void reserve(size_type n) {
+        if (n > capacity()) reallocate_storage(n, use_reallocate());
     }
-    vector(const_iterator first, const_iterator last, 
-           const allocator_type& a = allocator_type()) : data_allocator(a) {
-        start = allocate_and_copy(last - first, first, last);
-        finish = end_of_storage = start + (last - first);
-    }
-    vector<T, Alloc>& operator=(const vector<T, Alloc>& x);
 
-    ~vector() {
-        destroy(start, finish);
-        deallocate();
-    }
+    reference operator[](size_type n)
+        { return *(begin() + n); }
+    const_reference operator[](size_type n) const
+        { return *(begin() + n); }
 
     reference front() { return *begin(); }
     const_reference front() const { return *begin(); }
@@ -110,164 +202,401 @@ public:
 
     void push_back(const T& x) {
         if (finish != end_of_storage) {
-            construct(finish, x);
+            ministl::construct(finish, x);
             ++finish;
         }
         else
             insert_aux(end(), x);
     }
 
+    void push_back(T&& x) {
+        emplace_back(ministl::move(x));
+    }
+
+    // 以 args 为参数直接在尾部构造元素，不产生临时对象
+    template <typename ... Args>
+    void emplace_back(Args&& ... args) {
+        if (finish != end_of_storage) {
+            ministl::construct(finish, ministl::forward<Args>(args)...);
+            ++finish;
+        }
+        else
+            insert_aux(end(), ministl::forward<Args>(args)...);
+    }
+
     void pop_back() {
         --finish;
-        destroy(finish);
+        ministl::destroy(finish);
     }
 
     iterator erase(iterator position) {
         if (position + 1 != end())
-            copy(position + 1, finish, position);
+            ministl::move(position + 1, finish, position);
         --finish;
-        destroy(finish);
+        ministl::destroy(finish);
         return position;
     }
 
     iterator erase(iterator first, iterator last) {
-        iterator i = copy(last, finish, first);
-        destory(i, finish);
+        // 空区间时 move 会把每个元素移动赋值给自己，std::string 等类型会被清空
+        if (first == last) return first;
+        iterator i = ministl::move(last, finish, first);
+        ministl::destroy(i, finish);
         finish = finish - (last - first);
         return first;
     }
 
     void resize(size_type new_size, const T& x) {
         if (new_size < size())
-            erase(begin() + new_size, x);
+            erase(begin() + new_size, end());
         else
             insert(end(), new_size - size(), x);
     }
-    void resize(size_type new_size) 
+    void resize(size_type new_size)
         { resize(new_size, T()); }
-    void clear() 
+    void clear()
         { erase(begin(), end()); }
 
+    // 新增的元素默认初始化，对于 int、char 等类型不清零，内容未定义
+    // 用于随后会被整体覆盖的缓冲区，例如 v.resize_uninitialized(n); read(fd, v.begin(), n);
+    void resize_uninitialized(size_type new_size) {
+        if (new_size < size())
+            erase(begin() + new_size, end());
+        else {
+            if (new_size > capacity())
+                reallocate_storage(next_capacity(new_size), use_reallocate());
+            finish = ministl::uninitialized_default_n(finish, new_size - size());
+        }
+    }
+
+    // 把 [first, last) 接到末尾，只检查一次容量，POD 类型一次 memmove 完成
+    void append(const_iterator first, const_iterator last);
+
+    // 在末尾添加 n 个 x
+    void append_n(size_type n, const T& x) {
+        if (size_type(end_of_storage - finish) < n) {
+            // x 可能引用原有元素，扩容之前先复制一份
+            T x_copy = x;
+            reallocate_storage(next_capacity(size() + n), use_reallocate());
+            finish = ministl::uninitialized_fill_n(finish, n, x_copy);
+        }
+        else
+            finish = ministl::uninitialized_fill_n(finish, n, x);
+    }
+
     void insert(iterator position, size_type n, const T& x);
 
     iterator insert(iterator position, const T& x) {
+        return emplace(position, x);
+    }
+
+    iterator insert(iterator position, T&& x) {
+        return emplace(position, ministl::move(x));
+    }
+
+    // 以 args 为参数在 position 处构造元素
+    template <typename ... Args>
+    iterator emplace(iterator position, Args&& ... args) {
         size_type n = position - begin();
         if (finish != end_of_storage && position == end()) {
-            construct(finish, x);
+            ministl::construct(finish, ministl::forward<Args>(args)...);
             ++finish;
         }
         else
-            insert_aux(position, x);
+            insert_aux(position, ministl::forward<Args>(args)...);
         return begin() + n;
     }
 
     void insert(iterator position, const_iterator first, const_iterator last);
+};
+
+// Growth 决定扩容时的新容量，见 growth_policy.h
+template<typename T, typename Alloc = ministl::allocator<T>, typename Growth = double_growth>
+class vector : public _vector_base<T, Alloc, Growth, vector<T, Alloc, Growth> > {
+    typedef _vector_base<T, Alloc, Growth, vector<T, Alloc, Growth> > base;
+    friend class _vector_base<T, Alloc, Growth, vector<T, Alloc, Growth> >;
+
+public:
+    typedef typename base::value_type       value_type;
+    typedef typename base::pointer          pointer;
+    typedef typename base::const_pointer    const_pointer;
+    typedef typename base::iterator         iterator;
+    typedef typename base::const_iterator   const_iterator;
+    typedef typename base::reference        reference;
+    typedef typename base::const_reference  const_reference;
+    typedef typename base::size_type        size_type;
+    typedef typename base::difference_type  difference_type;
+    typedef typename base::allocator_type   allocator_type;
+    typedef typename base::growth_policy    growth_policy;
+
+protected:
+    using base::data_allocator;
+    using base::start;
+    using base::finish;
+    using base::end_of_storage;
+    using base::deallocate;
+    using base::next_capacity;
+    using base::reallocate_storage;
+    typedef typename base::use_reallocate use_reallocate;
 
+    void fill_initialize(size_type n, const T& value) {
+        start = this->allocate_and_fill(n, value);
+        finish = start + n;
+        end_of_storage = finish;
+    }
+
+public:
+    using base::size;
+    using base::capacity;
+    using base::erase;
+
+    // 释放多余的容量
+    // 容量只保留到配置器为 size() 个元素实际分配的区块大小，已经没有多余区块时什么也不做
+    void shrink_to_fit() {
+        if (start == finish) {
+            deallocate();
+            start = finish = end_of_storage = nullptr;
+            return;
+        }
+        size_type len = _good_capacity<allocator_type>(size());
+        if (len < capacity()) reallocate_storage(len, use_reallocate());
+    }
+
+    vector() { }
+    // 有状态的配置器 (例如 polymorphic_allocator) 通过构造函数传入
+    explicit vector(const allocator_type& a) : base(a) { }
+    vector(size_type n, const T& value, const allocator_type& a = allocator_type())
+        : base(a) { fill_initialize(n, value); }
+    explicit vector( size_type n )
+        { fill_initialize(n, T()); }
+    // n 个元素默认初始化，对于 int、char 等类型不清零，见 uninitialized_default_n
+    vector(size_type n, default_init_t, const allocator_type& a = allocator_type())
+        : base(a) {
+        start = data_allocator.allocate(n);
+        try {
+            finish = ministl::uninitialized_default_n(start, n);
+        }
+        catch (...) {
+            data_allocator.deallocate(start, n);
+            throw;
+        }
+        end_of_storage = start + n;
+    }
+    // 多个线程并行构造，物理页分布在各个线程的 NUMA 节点上，定义在 parallel.h 中
+    vector(size_type n, const T& value, const parallel_t& p,
+           const allocator_type& a = allocator_type());
+    vector(const_iterator first, const_iterator last, const parallel_t& p,
+           const allocator_type& a = allocator_type());
+    vector(const vector<T, Alloc, Growth>& x) : base(x.get_allocator()) {
+        start = this->allocate_and_copy(x.size(), x.begin(), x.end());
+        finish = end_of_storage = start + x.size();
+    }
+    vector(const_iterator first, const_iterator last,
+           const allocator_type& a = allocator_type()) : base(a) {
+        start = this->allocate_and_copy(last - first, first, last);
+        finish = end_of_storage = start + (last - first);
+    }
+    // 移动构造，直接接管 x 的空间
+    vector(vector<T, Alloc, Growth>&& x) noexcept : base(x.data_allocator) {
+        start = x.start;
+        finish = x.finish;
+        end_of_storage = x.end_of_storage;
+        x.start = x.finish = x.end_of_storage = nullptr;
+    }
+    vector<T, Alloc, Growth>& operator=(const vector<T, Alloc, Growth>& x) {
+        if (&x != this) this->assign_copy(x.begin(), x.end());
+        return *this;
+    }
+    vector<T, Alloc, Growth>& operator=(vector<T, Alloc, Growth>&& x);
+
+    ~vector() {
+        ministl::destroy(start, finish);
+        deallocate();
+    }
+
+    void swap(vector<T, Alloc, Growth>& x) {
+        allocator_type a = data_allocator;
+        data_allocator = x.data_allocator;
+        x.data_allocator = a;
+        iterator tmp = start; start = x.start; x.start = tmp;
+        tmp = finish; finish = x.finish; x.finish = tmp;
+        tmp = end_of_storage; end_of_storage = x.end_of_storage; x.end_of_storage = tmp;
+    }
+
+    using base::resize;
+    // 新增的元素并行构造，定义在 parallel.h 中
+    void resize(size_type new_size, const T& x, const parallel_t& p);
 };
 
-// TODO ==
-template <typename T, typename Alloc>
-inline bool 
-operator==(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
-    return &lhs == &rhs;
+// 元素个数相同并且逐个相等，trivially comparable 的元素使用 memcmp
+template <typename T, typename Alloc, typename Growth>
+inline bool
+operator==(const vector<T, Alloc, Growth>& lhs, const vector<T, Alloc, Growth>& rhs) {
+    return lhs.size() == rhs.size()
+        && ministl::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-// TODO <
-template <typename T, typename Alloc>
+// 字典序
+template <typename T, typename Alloc, typename Growth>
 inline bool
-operator<(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
-    return true;
+operator<(const vector<T, Alloc, Growth>& lhs, const vector<T, Alloc, Growth>& rhs) {
+    return ministl::lexicographical_compare(lhs.begin(), lhs.end(),
+                                            rhs.begin(), rhs.end());
 }
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, typename Growth>
 inline bool
-operator!=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+operator!=(const vector<T, Alloc, Growth>& lhs, const vector<T, Alloc, Growth>& rhs) {
     return !(lhs == rhs);
 }
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, typename Growth>
 inline bool
-operator>(const vector<T, Alloc>&lhs, const vector<T, Alloc>& rhs) {
+operator>(const vector<T, Alloc, Growth>&lhs, const vector<T, Alloc, Growth>& rhs) {
     return rhs < lhs;
 }
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, typename Growth>
 inline bool
-operator<=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+operator<=(const vector<T, Alloc, Growth>& lhs, const vector<T, Alloc, Growth>& rhs) {
     return !(rhs < lhs);
 }
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, typename Growth>
 inline bool
-operator>=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+operator>=(const vector<T, Alloc, Growth>& lhs, const vector<T, Alloc, Growth>& rhs) {
     return !(lhs < rhs);
 }
 
-template <typename T, typename Alloc>
-vector<T, Alloc>&
-vector<T, Alloc>::operator=(const vector<T, Alloc>& x) {
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::assign_copy(const_iterator first, const_iterator last) {
+    const size_type xlen = last - first;
+    if (xlen > capacity()) {
+        iterator temp = allocate_and_copy(xlen, first, last);
+        replace_storage(temp, temp + xlen, xlen);
+    }
+    else if (size() >= xlen) {
+        iterator i = ministl::copy(first, last, begin());
+        ministl::destroy(i, finish);
+        finish = i;
+    }
+    else {
+        ministl::copy(first, first + size(), begin());
+        finish = ministl::uninitialized_copy(first + size(), last, finish);
+    }
+}
+
+template <typename T, typename Alloc, typename Growth>
+vector<T, Alloc, Growth>&
+vector<T, Alloc, Growth>::operator=(vector<T, Alloc, Growth>&& x) {
     if (&x != this) {
-        const size_type xlen = x.size();
-        if (xlen > capacity()) {
-            iterator temp = allocate_and_copy(xlen, x.begin(), x.end());
-            destroy(start, finish);
-            data_allocator.deallocate(start, end_of_storage - start);
-            start = temp;
-            end_of_storage = start + xlen;
-        }
-        else if (size() >= xlen) {
-            iterator i = copy(x.begin(), x.end(), begin());
-            destroy(i, finish);
+        if (data_allocator == x.data_allocator) {
+            // 两个配置器的内存可以互相归还，直接接管 x 的空间
+            ministl::destroy(start, finish);
+            deallocate();
+            start = x.start;
+            finish = x.finish;
+            end_of_storage = x.end_of_storage;
+            x.start = x.finish = x.end_of_storage = nullptr;
         }
         else {
-            copy(x.begin(), x.begin() + , begin());
-            uninitialized_copy(x.begin() + size(), x.end(), finish);
+            // 例如两个 polymorphic_allocator 使用不同的 memory_resource，只能逐个移动元素
+            const size_type xlen = x.size();
+            iterator temp = data_allocator.allocate(xlen);
+            try {
+                ministl::uninitialized_move_if_noexcept(x.begin(), x.end(), temp);
+            }
+            catch (...) {
+                data_allocator.deallocate(temp, xlen);
+                throw;
+            }
+            this->replace_storage(temp, temp + xlen, xlen);
+            x.clear();
         }
-        finish = start + xlen;
     }
     return *this;
 }
 
-template <typename T, typename Alloc>
-void vector<T, Alloc>::insert_aux(iterator position, const T& x) {
+template <typename T, typename Alloc, typename Growth, typename Derived>
+template <typename ... Args>
+void _vector_base<T, Alloc, Growth, Derived>::insert_aux(iterator position, Args&& ... args) {
     if (finish != end_of_storage) {         // 如果还有空间
-        // 在最后一个空间
-        construct(finish, *(finish - 1));
+        // 先构造新元素，args 可能引用 vector 中将要被移动的元素
+        T x_copy(ministl::forward<Args>(args)...);
+        // 在最后一个空间以最后一个元素移动构造
+        ministl::construct(finish, ministl::move(*(finish - 1)));
         ++finish;
-        T x_copy = x;
-        copy_backward(position, finish-2, finish-1);
-        *position = x_copy;
+        ministl::move_backward(position, finish-2, finish-1);
+        *position = ministl::move(x_copy);
     }
     else {
-        const size_type old_size = size();
-        const size_type len = old_size == 0 ? 1 : old_size * 2;
-        iterator new_start = data_allocator.allocate(len);
-        iterator new_finish = new_start;
-        try {
-            new_finish = uninitialized_copy(start, position, new_start);
-            construct(new_finish, x);
-            ++new_finish;
-            new_finish = uninitialized_copy(position, finish, new_finish);
-        }
-        catch (...) {
-            destroy(new_start, new_finish);
-            data_allocator.deallocate(new_start, len);
-            throw;
-        }
+        const size_type len = next_capacity(size() + 1);
+        realloc_insert(use_reallocate(), len, position, ministl::forward<Args>(args)...);
+    }
+}
 
-        // 析构并释放原 vector
-        destroy(begin(), end());
-        deallocate();
+template <typename T, typename Alloc, typename Growth, typename Derived>
+template <typename ... Args>
+void _vector_base<T, Alloc, Growth, Derived>::realloc_insert(true_type, size_type len,
+                                                             iterator position, Args&& ... args) {
+    // args 可能引用原有元素，reallocate 之后原来的地址可能已经失效
+    T x(ministl::forward<Args>(args)...);
+    position = reallocate_gap(position, 1, len);
+    try {
+        ministl::construct(position, ministl::move(x));
+    }
+    catch (...) {
+        close_gap(position, 1);
+        throw;
+    }
+    ++finish;
+}
 
-        // 调整迭代器，指向新 vector
-        start = new_start;
-        finish = new_finish;
-        end_of_storage = new_start + len;
+template <typename T, typename Alloc, typename Growth, typename Derived>
+template <typename ... Args>
+void _vector_base<T, Alloc, Growth, Derived>::realloc_insert(false_type, size_type len,
+                                                             iterator position, Args&& ... args) {
+    const size_type elems_before = position - start;
+    iterator new_start = data_allocator.allocate(len);
+    iterator new_finish = new_start;
+    try {
+        // 先在新空间中构造新元素，此时 args 引用的原有元素还没有被移动
+        ministl::construct(new_start + elems_before, ministl::forward<Args>(args)...);
+        new_finish = nullptr;
+        // 原有元素的移动构造是 noexcept 时移动，否则复制，每个元素只需要一次移动
+        new_finish = ministl::uninitialized_move_if_noexcept(start, position, new_start);
+        ++new_finish;
+        new_finish = ministl::uninitialized_move_if_noexcept(position, finish, new_finish);
+    }
+    catch (...) {
+        // new_finish 为 nullptr 说明只构造了新元素
+        if (nullptr == new_finish) ministl::destroy(new_start + elems_before);
+        else ministl::destroy(new_start, new_finish);
+        data_allocator.deallocate(new_start, len);
+        throw;
+    }
+    // 析构并释放原有空间，指向新空间
+    replace_storage(new_start, new_finish, len);
+}
+
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::append(const_iterator first, const_iterator last) {
+    const size_type n = last - first;
+    if (size_type(end_of_storage - finish) < n) {
+        // [first, last) 可能是本 vector 的一部分，扩容之后按偏移重新定位
+        const bool inside = first >= start && first < finish;
+        const size_type offset = first - start;
+        reallocate_storage(next_capacity(size() + n), use_reallocate());
+        if (inside) {
+            first = start + offset;
+            last = first + n;
+        }
     }
+    finish = ministl::uninitialized_copy(first, last, finish);
 }
 
-template <typename T, typename Alloc>
-void vector<T, Alloc>::insert(iterator position, size_type n, const T& x) {
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::insert(iterator position, size_type n, const T& x) {
     if (n != 0) {
         if (size_type(end_of_storage - finish) >= n) {
             T x_copy = x;
@@ -275,109 +604,141 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const T& x) {
             iterator old_finish = finish;
             if (elems_after > n) {
                 // 插入点之后的现有元素个数大于新增元素个数
-                // 将 [finish-n, finish) 复制到 [finish, finish + n)
-                uninitialized_copy(finish - n, finish, finish);
+                // 将 [finish-n, finish) 移动到 [finish, finish + n)
+                ministl::uninitialized_move_if_noexcept(finish - n, finish, finish);
                 finish += n;
-                // 将 [position, old_finish - n) 复制到 [..., old_finish)
-                copy_backward(position, old_finish - n, old_finish);
+                // 将 [position, old_finish - n) 移动到 [..., old_finish)
+                ministl::move_backward(position, old_finish - n, old_finish);
                 // 将 [position, position + n) 使用 x_copy 填充
-                fill(position, position + n, x_copy);
+                ministl::fill(position, position + n, x_copy);
             }
             else {
                 // 插入点之后的现有元素个数小于等于新增元素个数
                 // 将 [finish, finish + (n - elems_after)) 使用 x_copy 填充
-                uninitialized_fill_n(finish, n - elems_after, x_copy);
+                ministl::uninitialized_fill_n(finish, n - elems_after, x_copy);
                 finish += n - elems_after;
-                // 将 [position, old_finish) 复制到 [finish, ...)
-                uninitialized_copy(position, old_finish, finish);
+                // 将 [position, old_finish) 移动到 [finish, ...)
+                ministl::uninitialized_move_if_noexcept(position, old_finish, finish);
                 finish += elems_after;
                 // 将 [position, old_finish) 使用 x_copy 填充
-                fill(position, old_finish, x_copy);
+                ministl::fill(position, old_finish, x_copy);
             }
         }
         else {
             // 备用空间小于 “新增元素个数”
-            // 首先决定新长度:旧长度的两倍，或旧长度+新增元素个数
-            const size_type old_size = size();
-            const size_type len = old_size + max(old_size, n);
-            // 分配新的空间
-            iterator new_start = data_allocator.allocate(len);
-            iterator new_finish = new_start;
-            try {
-                // 将 [start, position) 复制到 [new_start, ...)
-                new_finish = uninitialized_copy(start, position, new_start);
-                // 将 [new_finish, new_finish + n) 使用 x 填充
-                new_finish = uninitialized_fill_n(new_finish, n, x);
-                // 将 [position, finish) 复制到 [new_finish, ...)
-                new_finish = uninitialized_copy(position, finish, new_finish);
-            }
-            catch {
-                // commit or rollback
-                destroy(new_start, new_finish);
-                data_allocator.deallocate(new_start, len);
-                throw();
-            }
+            // 新长度由增长策略决定，至少为旧长度+新增元素个数
+            const size_type len = next_capacity(size() + n);
+            // x 可能引用原有元素，先复制一份
+            T x_copy = x;
+            realloc_fill_insert(position, n, x_copy, len, use_reallocate());
         }
-        // 清楚并释放旧的 vector
-        destroy(start, finish);
-        deallocate();
-        start = new_start;
-        finish = new_finish;
-        end_of_storage = new_start + len;
     }
 }
 
-template <typename T, typename Alloc>
-void vector<T, Alloc>::insert(iterator position, const_iterator first,
-                                                 const_iterator last) {
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::realloc_fill_insert(iterator position, size_type n,
+                                                                  const T& x, size_type len, true_type) {
+    position = reallocate_gap(position, n, len);
+    try {
+        ministl::uninitialized_fill_n(position, n, x);
+    }
+    catch (...) {
+        close_gap(position, n);
+        throw;
+    }
+    finish += n;
+}
+
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::realloc_fill_insert(iterator position, size_type n,
+                                                                  const T& x, size_type len, false_type) {
+    // 分配新的空间
+    iterator new_start = data_allocator.allocate(len);
+    iterator new_finish = new_start;
+    try {
+        // 将 [start, position) 移动到 [new_start, ...)
+        new_finish = ministl::uninitialized_move_if_noexcept(start, position, new_start);
+        // 将 [new_finish, new_finish + n) 使用 x 填充
+        new_finish = ministl::uninitialized_fill_n(new_finish, n, x);
+        // 将 [position, finish) 移动到 [new_finish, ...)
+        new_finish = ministl::uninitialized_move_if_noexcept(position, finish, new_finish);
+    }
+    catch (...) {
+        // commit or rollback
+        ministl::destroy(new_start, new_finish);
+        data_allocator.deallocate(new_start, len);
+        throw;
+    }
+    // 清除并释放旧的空间
+    replace_storage(new_start, new_finish, len);
+}
+
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::insert(iterator position, const_iterator first,
+                                                     const_iterator last) {
     if (first != last) {
         size_type n = 0;
-        n = distance(first, last);
+        n = ministl::distance(first, last);
         if (size_type(end_of_storage - finish) >= n) {
             const size_type elems_after = finish - position;
             iterator old_finish = finish;
             if (elems_after > n) {
-                uninitialized_copy(finish - n, finish, finish);
+                ministl::uninitialized_move_if_noexcept(finish - n, finish, finish);
                 finish += n;
-                copy_backward(position, old_finish - n, finish);
-                copy(first, last, position);
+                ministl::move_backward(position, old_finish - n, old_finish);
+                ministl::copy(first, last, position);
             }
             else {
-                uninitialized_copy(first + elems_after, last, finish);
+                ministl::uninitialized_copy(first + elems_after, last, finish);
                 finish += n - elems_after;
-                uninitialized_copy(position, old_finish, finish);
+                ministl::uninitialized_move_if_noexcept(position, old_finish, finish);
                 finish += elems_after;
-                copy(first, first + elems_after, position);
+                ministl::copy(first, first + elems_after, position);
             }
         }
         else {
-            const size_type old_size = size();
-            const size_type len = old_size + max(old_size, n);
-            iterator new_start = data_allocator.allocate(len);
-            iterator new_finish = new_start;
-            try {
-                new_finish = uninitialized_copy(start, position, new_finish);
-                new_finish = uninitialized_copy(first, last, new_finish);
-                new_finish = uninitialized_copy(position, finish, new_finish);
-            }
-            catch(...) {
-                destroy(new_start, new_finish);
-                data_allocator.deallocate(new_start, len);
-                throw();
-            }
-            destroy(start, finish);
-            data_allocator.deallocate(start, end_of_storage - start);
-            start = new_start;
-            finish = new_finish;
-            end_of_storage = new_start + len;
+            const size_type len = next_capacity(size() + n);
+            realloc_range_insert(position, first, last, len, use_reallocate());
         }
     }
 }
 
-
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::realloc_range_insert(iterator position, const_iterator first,
+                                                                   const_iterator last, size_type len, true_type) {
+    const size_type n = last - first;
+    position = reallocate_gap(position, n, len);
+    try {
+        ministl::uninitialized_copy(first, last, position);
+    }
+    catch (...) {
+        close_gap(position, n);
+        throw;
+    }
+    finish += n;
 }
 
-#endif // MINISTL_VECTOR_H
+template <typename T, typename Alloc, typename Growth, typename Derived>
+void _vector_base<T, Alloc, Growth, Derived>::realloc_range_insert(iterator position, const_iterator first,
+                                                                   const_iterator last, size_type len, false_type) {
+    iterator new_start = data_allocator.allocate(len);
+    iterator new_finish = new_start;
+    try {
+        new_finish = ministl::uninitialized_move_if_noexcept(start, position, new_finish);
+        new_finish = ministl::uninitialized_copy(first, last, new_finish);
+        new_finish = ministl::uninitialized_move_if_noexcept(position, finish, new_finish);
+    }
+    catch(...) {
+        ministl::destroy(new_start, new_finish);
+        data_allocator.deallocate(new_start, len);
+        throw;
+    }
+    replace_storage(new_start, new_finish, len);
+}
 
+}
 
+// vector<bool> 的特化
+#include "bvector.h"
 
+#endif // MINISTL_VECTOR_H
@@ -4,6 +4,10 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <thread>
+#include <chrono>
+#include <new>             // for bad_alloc
+#include <sys/mman.h>      // for mincore
 #include "../include/allocator.h"
 
 using std::cout;
@@ -21,6 +25,86 @@ struct alloc_test {
     std::string s;
 };
 
+struct alignas(64) cache_line {
+    char data[64];
+};
+
+// 1..MAX_BYTES 中的每个大小都落在能容纳它的最小的 size class 中，index 和 size 互逆
+template <typename SizeClass>
+bool check_size_class(size_t steps) {
+    for (size_t i = 0; i < SizeClass::NFREELISTS; ++i)
+        if (SizeClass::index(SizeClass::size(i)) != i) return false;
+    if (SizeClass::size(SizeClass::NFREELISTS - 1) != SizeClass::MAX_BYTES) return false;
+    for (size_t n = 1; n <= SizeClass::MAX_BYTES; ++n) {
+        size_t i = SizeClass::index(n);
+        if (i >= SizeClass::NFREELISTS || SizeClass::size(i) < n) return false;
+        if (i > 0 && SizeClass::size(i - 1) >= n) return false;
+        // 内部碎片小于区块大小的 1/(steps+1)
+        if (n > 2 * steps * SizeClass::ALIGN && (SizeClass::size(i) - n) * (steps + 1) >= SizeClass::size(i))
+            return false;
+    }
+    return true;
+}
+
+// [p, p + n) 中驻留在内存中的页数，p 按页对齐
+size_t resident_pages(void *p, size_t n) {
+    const size_t page = 4096;
+    unsigned char vec[64];
+    if (n / page > sizeof(vec) || 0 != mincore(p, n, vec)) return (size_t) -1;
+    size_t count = 0;
+    for (size_t i = 0; i < n / page; ++i)
+        count += vec[i] & 1;
+    return count;
+}
+
+typedef ministl::pool_alloc_template<ministl::linear_size_class<16, 1024> > trim_alloc;
+const int TRIM_BLOCKS = 4096;
+
+void trim_fill(void **blocks) {
+    for (int i = 0; i < TRIM_BLOCKS; ++i) {
+        blocks[i] = trim_alloc::allocate(1024);
+        memset(blocks[i], 1, 1024);
+    }
+}
+
+typedef ministl::pool_alloc_template<ministl::linear_size_class<>, ministl::mmap_chunk_source> huge_alloc;
+typedef ministl::region_chunk_source<1 << 20> small_region;
+typedef ministl::pool_alloc_template<ministl::linear_size_class<>, small_region> region_alloc;
+
+// 单独的实例，统计不受其他测试影响
+typedef ministl::pool_alloc_template<ministl::linear_size_class<16, 256> > thread_alloc;
+
+// 在线程的第一次分配之前构造，所以在归还线程缓存之后才析构
+struct late_free {
+    void *small;
+    void *large;
+    ~late_free() {
+        // 其他线程中也可能构造 (同一个文件中的 thread_local 一起初始化)
+        if (nullptr == small) return;
+        thread_alloc::deallocate(small, 48);
+        thread_alloc::deallocate(large, 1000);
+        // 线程缓存归还之后的分配也经过中心内存池
+        thread_alloc::deallocate(thread_alloc::allocate(32), 32);
+    }
+};
+
+thread_local late_free late;
+
+void thread_work(void **shared, int k) {
+    (void) &late;
+    late.small = thread_alloc::allocate(48);
+    late.large = thread_alloc::allocate(1000);
+    void *blocks[500];
+    for (int round = 0; round < 20; ++round) {
+        for (int i = 0; i < 500; ++i)
+            blocks[i] = thread_alloc::allocate(16 + (i % 16) * 16);
+        for (int i = 0; i < 500; ++i)
+            thread_alloc::deallocate(blocks[i], 16 + (i % 16) * 16);
+    }
+    // 交给另一个线程释放
+    shared[k] = thread_alloc::allocate(64);
+}
+
 int main () {
     // std::vector<int, ministl::allocator<int>> intVec;
     // for (int i = 0; i < 10; ++i)
@@ -38,4 +122,168 @@ int main () {
     testVec.erase(testVec.begin());
     cout << testVec.size() << endl;
     testVec[0].show();
+
+    ministl::default_alloc_template::alloc_stats stats = 
+        ministl::default_alloc_template::get_stats();
+    for (int i = 0; i < 16; ++i) {
+        const ministl::default_alloc_template::class_stats & c = stats.classes[i];
+        if (0 == c.allocations) continue;
+        cout << "class " << c.bytes << ": allocations " << c.allocations
+             << ", frees " << c.frees << ", refills " << c.refills
+             << " (" << c.refilled_objs << " objs), releases " << c.releases
+             << ", free objs " << c.free_objs << endl;
+    }
+    cout << "heap_size: " << stats.heap_size
+         << ", free_list_bytes: " << stats.free_list_bytes
+         << ", pool_bytes: " << stats.pool_bytes << endl;
+    cout << "large allocations: " << stats.large_allocations
+         << ", large frees: " << stats.large_frees << endl;
+
+    // alignof(T) 大于 8 时 allocator 使用 allocate_aligned
+    std::vector<cache_line, ministl::allocator<cache_line>> lineVec(3);
+    cout << "cache_line offset: " << ((size_t) lineVec.data() & 63) << endl;
+    void *page = ministl::geometric_alloc_template::allocate_aligned(4096, 4096);
+    cout << "page offset: " << ((size_t) page & 4095) << endl;
+    ministl::geometric_alloc_template::deallocate_aligned(page, 4096, 4096);
+
+    cout << "size classes: "
+         << check_size_class<ministl::geometric_size_class<4096> >(4)
+         << check_size_class<ministl::geometric_size_class<65536, 8, 16> >(8)
+         << check_size_class<ministl::geometric_size_class<1024, 1> >(1)
+         << check_size_class<ministl::linear_size_class<8, 128> >(16) << endl;
+
+    // trim() 把完整的空闲页交还操作系统，整个空闲的 chunk 归还 heap
+    void **blocks = new void *[TRIM_BLOCKS];
+    trim_fill(blocks);
+    size_t heap_before = trim_alloc::get_stats().heap_size;
+    // 每 16 个区块保留一个，其余 15KB 的空闲区域中至少有两个完整的页
+    for (int i = 0; i < TRIM_BLOCKS; ++i)
+        if (i % 16 != 0) trim_alloc::deallocate(blocks[i], 1024);
+    size_t purged = trim_alloc::trim();
+    char *freed_page = nullptr;
+    for (int i = 0; i + 16 < TRIM_BLOCKS && nullptr == freed_page; i += 16) {
+        char *first = (char *) blocks[i] + 1024;
+        if ((char *) blocks[i + 15] != first + 14 * 1024) continue;   // 不在同一个 chunk 中
+        char *p = (char *) (((size_t) first + 4095) & ~(size_t) 4095);
+        if (p + 2 * 4096 <= first + 15 * 1024) freed_page = p;
+    }
+    trim_alloc::alloc_stats trimmed = trim_alloc::get_stats();
+    cout << "trim: released " << (purged > 0) << ", counted " << (trimmed.trimmed_bytes == purged)
+         << ", spans " << (trimmed.span_bytes > 0) << ", freed pages resident "
+         << (freed_page ? resident_pages(freed_page, 2 * 4096) : (size_t) -1) << endl;
+    // 之后的分配先使用合并出来的区域
+    for (int i = 0; i < TRIM_BLOCKS / 2; ++i)
+        if (i % 16 != 0) blocks[i] = trim_alloc::allocate(1024);
+    cout << "trim: reused " << (trim_alloc::get_stats().heap_size <= heap_before) << endl;
+    for (int i = 0; i < TRIM_BLOCKS; ++i)
+        if (i < TRIM_BLOCKS / 2 || i % 16 == 0) trim_alloc::deallocate(blocks[i], 1024);
+    trim_alloc::trim();
+    trimmed = trim_alloc::get_stats();
+    cout << "trim all: heap " << trimmed.heap_size << ", chunks " << trimmed.chunks << endl;
+
+    // background_trimmer 回收其他线程退出时归还的区块
+    {
+        ministl::background_trimmer<trim_alloc> trimmer(std::chrono::milliseconds(10));
+        std::thread t([blocks] {
+            trim_fill(blocks);
+            for (int i = 0; i < TRIM_BLOCKS; ++i)
+                trim_alloc::deallocate(blocks[i], 1024);
+        });
+        t.join();
+        size_t heap = 0;
+        for (int i = 0; i < 200; ++i) {
+            heap = trim_alloc::get_stats().heap_size;
+            if (0 == heap) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        cout << "background trim: heap " << heap << endl;
+    }
+    delete [] blocks;
+
+    // mmap_chunk_source：chunk 按 2MB 对齐，大区块按页对齐，mremap 保留内容
+    const size_t huge = ministl::mmap_chunk_source::HUGE_PAGE;
+    void *small = huge_alloc::allocate(64);
+    void *large = huge_alloc::allocate(10000);
+    char *big = (char *) ministl::mmap_chunk_source::allocate(3 * huge);
+    big[0] = 'a';
+    big[3 * huge - 1] = 'z';
+    big = (char *) ministl::mmap_chunk_source::reallocate(big, 3 * huge, 5 * huge);
+    cout << "mmap: chunk offset " << ((size_t) small & (huge - 1))
+         << ", large offset " << ((size_t) large & 4095)
+         << ", big offset " << ((size_t) big & (huge - 1))
+         << ", remapped " << big[0] << big[3 * huge - 1] << endl;
+    ministl::mmap_chunk_source::deallocate(big, 5 * huge);
+
+    // 从小于 2MB 增长到 2MB 以上，结果仍然 2MB 对齐
+    char *grown = (char *) ministl::mmap_chunk_source::allocate(huge / 2);
+    grown[0] = 'a';
+    grown[huge / 2 - 1] = 'z';
+    grown = (char *) ministl::mmap_chunk_source::reallocate(grown, huge / 2, 3 * huge);
+    cout << "mmap: grown offset " << ((size_t) grown & (huge - 1))
+         << ", content " << grown[0] << grown[huge / 2 - 1] << endl;
+    ministl::mmap_chunk_source::deallocate(grown, 3 * huge);
+    huge_alloc::deallocate(large, 10000);
+    huge_alloc::deallocate(small, 64);
+
+    // region_chunk_source：释放的块与相邻的空闲块合并，整个区域可以再次分配
+    typedef ministl::region_chunk_source<1 << 16> tiny_region;
+    void *r1 = tiny_region::allocate(4096);
+    void *r2 = tiny_region::allocate(4096);
+    void *r3 = tiny_region::allocate(4096);
+    tiny_region::deallocate(r2, 4096);
+    tiny_region::deallocate(r1, 4096);
+    tiny_region::deallocate(r3, 4096);
+    void *whole = tiny_region::allocate(1 << 16);
+    cout << "region: coalesced " << (whole == tiny_region::base())
+         << ", exhausted " << (nullptr == tiny_region::allocate(16)) << endl;
+    tiny_region::deallocate(whole, 1 << 16);
+
+    // 区域用完之后先使用较大的 size class 中空闲的区块，都用完之后抛出 bad_alloc
+    std::thread([] {
+        void *p[512];
+        for (int i = 0; i < 512; ++i) p[i] = region_alloc::allocate(128);
+        for (int i = 0; i < 512; ++i) region_alloc::deallocate(p[i], 128);
+    }).join();
+    size_t spare = region_alloc::get_stats().classes[15].free_objs;
+    std::vector<void *> tiny;
+    bool exhausted = false, inside = true;
+    try {
+        for (;;) {
+            void *p = region_alloc::allocate(8);
+            tiny.push_back(p);
+            inside = inside && (char *) p >= small_region::base()
+                            && (char *) p < small_region::base() + (1 << 20);
+        }
+    }
+    catch (const std::bad_alloc &) {
+        exhausted = true;
+    }
+    cout << "region pool: exhausted " << exhausted << ", in region " << inside
+         << ", spare 128-byte blocks " << spare << " -> "
+         << region_alloc::get_stats().classes[15].free_objs << endl;
+    for (size_t i = 0; i < tiny.size(); ++i)
+        region_alloc::deallocate(tiny[i], 8);
+
+    // 线程退出之后，所有的分配和释放都计入统计，区块都回到中心内存池
+    void *shared[4];
+    std::thread workers[4];
+    for (int k = 0; k < 4; ++k)
+        workers[k] = std::thread(thread_work, shared, k);
+    for (int k = 0; k < 4; ++k)
+        workers[k].join();
+    std::thread freer([&shared] {
+        for (int k = 0; k < 4; ++k)
+            thread_alloc::deallocate(shared[k], 64);
+    });
+    freer.join();
+    thread_alloc::alloc_stats ts = thread_alloc::get_stats();
+    size_t allocations = 0, frees = 0;
+    for (size_t i = 0; i < 16; ++i) {
+        allocations += ts.classes[i].allocations;
+        frees += ts.classes[i].frees;
+    }
+    cout << "threads: allocations " << allocations << ", frees " << frees
+         << ", large " << ts.large_allocations << "/" << ts.large_frees
+         << ", large bytes " << ts.large_bytes
+         << ", all free " << (ts.free_list_bytes + ts.pool_bytes + ts.span_bytes == ts.heap_size) << endl;
 }
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include "../include/arena.h"
+#include "../include/vector.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+struct arena_test {
+    arena_test() : i(1), s("arena_test") {}
+    int i;
+    std::string s;
+};
+
+typedef vector<int, allocator<int, arena_alloc> > int_vector;
+typedef vector<arena_test, allocator<arena_test, arena_alloc> > test_vector;
+
+int main() {
+    monotonic_arena arena;
+    for (int round = 0; round < 3; ++round) {
+        {
+            arena_scope scope(arena);
+            int_vector iv;
+            for (int i = 0; i < 1000; ++i)
+                iv.push_back(i);
+            iv.erase(iv.begin(), iv.begin() + 10);
+            cout << "size: " << iv.size() << ", front: " << iv.front()
+                 << ", back: " << iv.back() << endl;
+
+            test_vector tv(3);
+            tv.push_back(arena_test());
+            tv[3].s = "last";
+            cout << "size: " << tv.size() << ", back: " << tv.back().s << endl;
+
+            // rebind 之后仍然使用 arena
+            allocator<int, arena_alloc>::rebind<double>::other da;
+            double *d = da.allocate(4);
+            da.deallocate(d, 4);
+            cout << "bytes allocated: " << arena.bytes_allocated() << endl;
+        }
+        arena.release();
+        cout << "after release: " << arena.bytes_allocated() << endl;
+    }
+
+    // block 大小不是对齐的倍数，以及超过 block 剩余空间的对齐要求，都不能越过 block 的尾
+    {
+        monotonic_arena small(100);
+        bool ok = true;
+        char * last = nullptr;
+        for (int i = 0; i < 1000; ++i) {
+            char * p = (char *) small.allocate(1);
+            *p = 'x';
+            ok = ok && ((size_t) p % monotonic_arena::ALIGN) == 0 && p != last;
+            last = p;
+        }
+        for (int i = 0; i < 100; ++i) {
+            char * p = (char *) small.allocate(8, 4096);
+            memset(p, 0, 8);
+            ok = ok && ((size_t) p % 4096) == 0;
+            small.allocate(24);
+        }
+        cout << "odd block size and over-aligned: " << ok << endl;
+    }
+
+    // 没有 arena 时抛出 bad_alloc
+    try {
+        int_vector iv;
+        iv.push_back(1);
+    } catch (const std::bad_alloc &) {
+        cout << "bad_alloc without arena" << endl;
+    }
+
+    vector<int> v(5, 7);
+    vector<int> w(v);
+    w.insert(w.begin() + 2, 3, 1);
+    w.resize(4);
+    for (size_t i = 0; i < w.size(); ++i)
+        cout << w[i] << " ";
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <iostream>
+#include "../include/vector.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+void print(const char * name, const bit_vector & v) {
+    cout << name << " (" << v.size() << "): ";
+    for (bit_vector::const_iterator it = v.begin(); it != v.end(); ++it)
+        cout << *it;
+    cout << endl;
+}
+
+int main() {
+    bit_vector v;
+    for (int i = 0; i < 20; ++i)
+        v.push_back(i % 3 == 0);
+    print("v", v);
+    cout << "count: " << v.count() << ", capacity: " << v.capacity() << endl;
+
+    v[1] = true;
+    v.flip();
+    print("flip", v);
+    v.insert(v.begin() + 2, 3, true);
+    v.erase(v.begin());
+    print("insert + erase", v);
+
+    cout << "true at:";
+    for (size_t i = v.find_first(); i != bit_vector::npos; i = v.find_next(i))
+        cout << " " << i;
+    cout << endl;
+
+    // 一百万个元素的位图
+    bit_vector a(1000000, false), b(1000000, true);
+    for (size_t i = 0; i < a.size(); i += 7)
+        a[i] = true;
+    b.pop_back();
+    b.push_back(false);
+    cout << "a: " << a.count() << ", b: " << b.count() << endl;
+    bit_vector c(a);
+    c &= b;
+    cout << "a & b: " << c.count() << endl;
+    c = a;
+    c ^= b;
+    cout << "a ^ b: " << c.count() << endl;
+    // 与自身运算
+    bit_vector d(a);
+    d &= d;
+    d |= d;
+    cout << "a & a | a: " << d.count() << ", ";
+    d ^= d;
+    cout << "a ^ a: " << d.count() << endl;
+    c.flip();
+    cout << "~(a ^ b): " << c.count() << " first " << c.find_first()
+         << " next " << c.find_next(c.find_first()) << endl;
+
+    cout << "compare: " << (c == c) << (a == b) << (bit_vector(3, true) < bit_vector(4, true)) << endl;
+    c.resize(10);
+    c.resize(100);
+    cout << "resize: " << c.count() << " " << (c.find_next(10) == bit_vector::npos) << endl;
+    cout << "sizeof: " << sizeof(bit_vector) << ", bytes: " << a.capacity() / 8 << endl;
+    return 0;
+}
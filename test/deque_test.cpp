@@ -0,0 +1,103 @@
+#include <iostream>
+#include <string>
+#include "../include/deque.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+template <typename Deque>
+void print(const char * name, const Deque & d) {
+    cout << name << " (" << d.size() << "):";
+    for (typename Deque::const_iterator it = d.begin(); it != d.end(); ++it)
+        cout << " " << *it;
+    cout << endl;
+}
+
+// 缓冲区应当正好是 Pool 的一个区块：大小等于所在 size class，并且不转交一级配置器
+template <typename Deque, typename Pool>
+void print_node(const char * name) {
+    typedef typename Deque::value_type value_type;
+    size_t bytes = Deque::iterator::buffer_size() * sizeof(value_type);
+    size_t large = Pool::get_stats().large_allocations;
+    {
+        // 几个缓冲区即可，map 保持在初始大小，不会因为 map 而转交一级配置器
+        Deque d;
+        for (size_t i = 0; i < 2 * Deque::iterator::buffer_size(); ++i) {
+            d.push_back(value_type());
+            d.push_front(value_type());
+        }
+    }
+    cout << name << ": node " << bytes << " bytes, size class " << Pool::good_size(bytes)
+         << ", large allocations " << Pool::get_stats().large_allocations - large << endl;
+}
+
+int main() {
+    // 每个缓冲区 4 个元素，便于观察跨缓冲区的情况
+    deque<int, allocator<int>, 4> d;
+    for (int i = 0; i < 10; ++i) {
+        d.push_back(i);
+        d.push_front(-i - 1);
+    }
+    print("d", d);
+
+    // 两端增长时元素不会移动
+    int * p = &d[10];
+    for (int i = 0; i < 1000; ++i) {
+        d.push_back(i);
+        d.push_front(i);
+    }
+    cout << "stable: " << (p == &d[1010]) << " " << *p << endl;
+    for (int i = 0; i < 1000; ++i) {
+        d.pop_back();
+        d.pop_front();
+    }
+    print("d", d);
+
+    d.insert(d.begin() + 3, 2, 100);
+    d.insert(d.end() - 3, 2, 200);
+    d.emplace(d.begin() + 1, 50);
+    print("insert", d);
+    d.erase(d.begin() + 2);
+    d.erase(d.begin() + 1, d.begin() + 4);
+    d.erase(d.end() - 6, d.end() - 2);
+    print("erase", d);
+
+    deque<int, allocator<int>, 4>::iterator it = d.begin() + 5;
+    cout << "iterator: " << *it << " " << it[3] << " " << (d.end() - it) << " "
+         << distance(d.begin(), d.end()) << " " << (it < d.end()) << endl;
+
+    deque<std::string> s;
+    s.push_back("b");
+    s.push_front("a");
+    s.emplace_back(3, 'c');
+    s.insert(s.begin() + 1, s.back());
+    deque<std::string> t(s);
+    deque<std::string> u(ministl::move(s));
+    t.resize(6, "z");
+    print("t", t);
+    print("u", u);
+    print("s", s);
+    s = t;
+    u = ministl::move(t);
+    s.clear();
+    s.push_back("again");
+    print("s", s);
+    print("u", u);
+
+    // 空区间的 erase 不改变任何元素
+    deque<std::string> e;
+    e.push_back("a");
+    e.push_back("b");
+    e.push_back("c");
+    e.erase(e.begin() + 1, e.begin() + 1);
+    print("empty erase", e);
+
+    // 缓冲区大小随 Alloc 的内存池调整
+    print_node<deque<int>, geometric_alloc_template>("default int");
+    print_node<deque<std::string>, geometric_alloc_template>("default string");
+    print_node<deque<int, allocator<int> >, default_alloc_template>("default_alloc int");
+    cout << "malloc_alloc int: node "
+         << deque<int, allocator<int, malloc_alloc> >::iterator::buffer_size() * sizeof(int) << " bytes" << endl;
+    return 0;
+}
@@ -0,0 +1,52 @@
+// 编译时需要 -rdynamic 才能在调用栈中看到函数名
+#define MINISTL_HEAP_PROFILER
+
+#include <iostream>
+#include "../include/vector.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+struct profile_test {
+    double d[4];
+};
+
+// 没有 good_size 的配置器，size class 的大小记为申请的字节数
+struct bare_alloc {
+    static void * allocate(size_t n) { return malloc(n); }
+    static void deallocate(void *p, size_t) { free(p); }
+};
+
+void fill_tests(vector<profile_test> & v) {
+    for (int i = 0; i < 100000; ++i)
+        v.push_back(profile_test());
+}
+
+void fill_ints(vector<int> & v) {
+    for (int i = 0; i < 100000; ++i)
+        v.push_back(i);
+}
+
+int main() {
+    heap_profiler::set_sample_interval(64 * 1024);
+    vector<profile_test> *tests = new vector<profile_test>;
+    vector<int> *ints = new vector<int>;
+    fill_tests(*tests);
+    fill_ints(*ints);
+    cout << "live samples: " << heap_profiler::live_samples() << endl;
+    heap_profiler::dump(stdout);
+
+    delete tests;
+    delete ints;
+
+    typedef allocator<char, bare_alloc> bare_allocator;
+    char *blocks[16];
+    for (int i = 0; i < 16; ++i)
+        blocks[i] = bare_allocator::allocate(64 * 1024);
+    cout << "bare samples: " << heap_profiler::live_samples() << endl;
+    for (int i = 0; i < 16; ++i)
+        bare_allocator().deallocate(blocks[i], 64 * 1024);
+    cout << "live samples after free: " << heap_profiler::live_samples() << endl;
+    return 0;
+}
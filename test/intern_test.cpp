@@ -0,0 +1,64 @@
+#include <iostream>
+#include <unordered_map>
+#include <cstdio>
+#include "../include/intern.h"
+#include "../include/string.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+int main() {
+    intern_pool pool;
+    interned_string a = pool.intern("content-type");
+    interned_string b = pool.intern(string("content-type"));
+    interned_string c = pool.intern("content-length");
+    cout << a << " " << (a == b) << " " << (a.data() == b.data()) << " " << (a != c) << " "
+         << a.id() << " " << c.id() << " " << pool.size() << endl;
+    cout << "find: " << (bool) pool.find("content-length") << " " << (bool) pool.find("accept") << " "
+         << (pool.find("content-type") == a) << " " << pool[1] << " " << pool.size() << endl;
+    cout << "view: " << (a.view() == string_view("content-type")) << " " << a.size() << " "
+         << (a.hash() == std::hash<interned_string>()(b)) << " [" << pool.intern("") << "] "
+         << pool.intern("").empty() << endl;
+
+    // 空句柄的编号不属于任何字符串
+    interned_string none = pool.find("accept");
+    cout << "none: " << none.empty() << " " << (none.id() == UINT32_MAX) << " ";
+    try {
+        pool.at(none.id());
+    }
+    catch (const std::out_of_range &) {
+        cout << "out_of_range";
+    }
+    cout << endl;
+
+    // 句柄作为 unordered_map 的键，hash 不需要重新计算
+    std::unordered_map<interned_string, int> counts;
+    const char * tags[] = { "GET", "POST", "GET", "PUT", "GET", "POST" };
+    for (int i = 0; i < 6; ++i) ++counts[pool.intern(tags[i])];
+    cout << "counts: " << counts[pool.intern("GET")] << " " << counts[pool.intern("POST")] << " "
+         << counts[pool.intern("PUT")] << endl;
+
+    // 一百万个字符串，只有 1000 个不同的值
+    const size_t N = 1000000, DISTINCT = 1000;
+    intern_pool tags_pool;
+    vector<interned_string> column;
+    column.reserve(N);
+    size_t heap_bytes = 0;
+    char buf[64];
+    for (size_t i = 0; i < N; ++i) {
+        int n = snprintf(buf, sizeof(buf), "service.region-%zu.instance.tag", i * 7919 % DISTINCT);
+        column.push_back(tags_pool.intern(string_view(buf, n)));
+        heap_bytes += sizeof(string) + (n > (int) string::SSO_CAPACITY ? n + 1 : 0);
+    }
+    bool ok = tags_pool.size() == DISTINCT;
+    for (size_t i = 0; i < N; i += 997) {
+        int n = snprintf(buf, sizeof(buf), "service.region-%zu.instance.tag", i * 7919 % DISTINCT);
+        ok = ok && column[i].view() == string_view(buf, n) && tags_pool[column[i].id()] == column[i];
+    }
+    size_t pooled = tags_pool.bytes_used() + column.size() * sizeof(interned_string);
+    cout << "dictionary: " << tags_pool.size() << " " << ok << " "
+         << "string bytes " << heap_bytes << " pooled bytes " << pooled << " "
+         << (pooled * 4 < heap_bytes) << endl;
+    return 0;
+}
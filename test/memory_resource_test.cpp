@@ -0,0 +1,53 @@
+#include <iostream>
+#include "../include/memory_resource.h"
+#include "../include/vector.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+typedef vector<int, polymorphic_allocator<int> > int_vector;
+
+struct alignas(64) cache_line {
+    char data[64];
+};
+
+void fill(int_vector & v, int n) {
+    for (int i = 0; i < n; ++i)
+        v.push_back(i);
+}
+
+int main() {
+    pool_resource pool;
+    malloc_resource heap;
+    monotonic_resource arena;
+
+    // 同一个类型的 vector 使用不同的内存来源
+    int_vector a(&pool), b(&heap), c(&arena);
+    fill(a, 100);
+    fill(b, 1000);
+    fill(c, 10000);
+    cout << a.size() << " " << b.size() << " " << c.size() << endl;
+    cout << "arena bytes: " << arena.bytes_allocated() << endl;
+
+    // 复制的 vector 使用同一个内存来源
+    int_vector d(c);
+    cout << "copy uses arena: " << (d.get_allocator().resource() == &arena) << endl;
+    cout << "arena bytes: " << arena.bytes_allocated() << endl;
+
+    // 默认构造的配置器使用默认的内存来源
+    memory_resource * old = set_default_resource(&heap);
+    int_vector e;
+    cout << "default is heap: " << (e.get_allocator().resource() == &heap) << endl;
+    set_default_resource(old);
+
+    cout << "pool == pool: " << (pool == *get_default_resource()) << endl;
+    cout << "pool == heap: " << (pool == heap) << endl;
+
+    // rebind 之后使用同一个内存来源，并满足 alignof(T)
+    polymorphic_allocator<cache_line> lines(a.get_allocator());
+    cache_line * p = lines.allocate(4);
+    cout << "cache_line offset: " << ((size_t) p & 63) << endl;
+    lines.deallocate(p, 4);
+    return 0;
+}
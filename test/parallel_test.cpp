@@ -0,0 +1,88 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <stdlib.h>         // for aligned_alloc
+#include "../include/parallel.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+// 构造到第 n 个时抛出异常，检查回滚
+struct thrower {
+    static std::atomic<int> alive;
+    static std::atomic<int> countdown;
+    int value;
+    thrower(int v) : value(v) { ++alive; }
+    thrower(const thrower & x) : value(x.value) {
+        if (0 == --countdown) throw 1;
+        ++alive;
+    }
+    ~thrower() { --alive; }
+};
+
+std::atomic<int> thrower::alive(0);
+std::atomic<int> thrower::countdown(0);
+
+// 记录构造自己的线程
+struct owner {
+    std::thread::id id;
+    owner() { }
+    owner(const owner &) : id(std::this_thread::get_id()) { }
+};
+
+template <typename F>
+double elapsed_ms(F f) {
+    std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t).count();
+}
+
+int main() {
+    const size_t n = 64 * 1024 * 1024;      // 512MB 的 double
+    double seq = elapsed_ms([&] {
+        vector<double> v(n, 1.5);
+        cout << "sequential: " << v[n - 1] << endl;
+    });
+    double par = elapsed_ms([&] {
+        vector<double> v(n, 1.5, parallel);
+        cout << "parallel: " << v[n - 1] << endl;
+    });
+    cout << "sequential " << (int) seq << " ms, parallel " << (int) par << " ms" << endl;
+
+    // 小区间不启动线程
+    vector<int> small(1000, 3, parallel);
+    small.resize(2000, 4, parallel);
+    cout << "small: " << small[999] << " " << small[1999] << endl;
+
+    // 指定 4 个线程，每个线程至少 1 字节
+    vector<std::string> words(1000, "word", parallel_t(4, true, 1));
+    vector<std::string> copy(words.begin(), words.end(), parallel_t(4, false, 1));
+    cout << "strings: " << copy.size() << " " << copy[999] << endl;
+
+    // 区间不按页对齐时，段的边界仍然落在页边界上，每一页只由一个线程构造
+    const size_t owners = 8 * 4096 / sizeof(owner);
+    char *raw = (char *) aligned_alloc(4096, 9 * 4096);
+    owner *o = (owner *) (raw + 8);
+    ministl::uninitialized_fill_n(parallel_t(4, false, 1), o, owners, owner());
+    bool one_owner = true;
+    size_t threads_seen = 1;
+    for (size_t i = 1; i < owners; ++i) {
+        if (o[i].id == o[i - 1].id) continue;
+        ++threads_seen;
+        one_owner = one_owner && 0 == (size_t) &o[i] % 4096;
+    }
+    cout << "page aligned segments: " << one_owner << ", threads " << threads_seen << endl;
+    free(raw);
+
+    thrower::countdown = 700;
+    try {
+        vector<thrower> t(1000, thrower(1), parallel_t(4, false, 1));
+    }
+    catch (int) {
+        cout << "rollback, alive: " << thrower::alive << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "../include/rope.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+int main() {
+    rope r("hello world");
+    r.insert(5, ",");
+    r.append("!");
+    r.insert(0, string(">> "));
+    cout << r << " " << r.size() << " " << r[3] << endl;
+    r.erase(0, 3);
+    rope sub = r.substr(7, 5);
+    cout << r << " [" << sub << "] " << (sub == rope("world")) << " " << (sub < r) << endl;
+
+    // 大文本：复制不复制字符，substr 和原来的 rope 共享叶节点
+    string big(1 << 20, 'x');
+    for (size_t i = 0; i < big.size(); i += 100) big[i] = 'a' + i % 26;
+    rope b(big);
+    rope c(b);
+    rope mid = b.substr(300000, 500000);
+    vector<const char *> leaves;
+    for (rope::chunk_iterator it = b.chunk_begin(); it != b.chunk_end(); ++it)
+        leaves.push_back(it->data());
+    size_t shared = 0;
+    for (rope::chunk_iterator it = mid.chunk_begin(); it != mid.chunk_end(); ++it)
+        for (size_t i = 0; i < leaves.size(); ++i)
+            shared += it->data() == leaves[i];
+    cout << "big: " << b.size() << " depth " << b.depth() << " " << (c == b) << " "
+         << (mid.to_string() == string_view(big).substr(300000, 500000)) << " shared " << shared << endl;
+
+    // 随机编辑，与 string 对照
+    srand(1);
+    string s;
+    rope t;
+    size_t errors = 0;
+    for (int i = 0; i < 3000; ++i) {
+        size_t pos = rand() % (s.size() + 1);
+        int op = rand() % 4;
+        if (op < 2) {
+            string frag(rand() % (op ? 10 : 5000) + 1, char('a' + rand() % 26));
+            s.insert(pos, frag);
+            t.insert(pos, frag);
+        }
+        else if (op == 2) {
+            size_t n = rand() % 3000;
+            s.erase(pos, n);
+            t.erase(pos, n);
+        }
+        else {
+            t = t.substr(0, pos) + t.substr(pos);
+        }
+        if (s.size() != t.size()) ++errors;
+    }
+    errors += t.to_string() != s;
+    for (size_t i = 0; i < s.size(); i += 997) errors += t[i] != s[i];
+    size_t chunks = 0;
+    for (rope::chunk_iterator it = t.chunk_begin(); it != t.chunk_end(); ++it) ++chunks;
+    cout << "random: " << t.size() << " errors " << errors << " balanced "
+         << (t.depth() <= 2 * 20) << " " << (chunks > 0) << endl;
+
+    // 逐个字符追加时短叶节点被合并
+    rope d;
+    for (int i = 0; i < 10000; ++i) d.append(string_view("0123456789" + i % 10, 1));
+    chunks = 0;
+    for (rope::chunk_iterator it = d.chunk_begin(); it != d.chunk_end(); ++it) ++chunks;
+    cout << "append: " << d.size() << " chunks " << chunks << " depth " << d.depth() << " "
+         << d.substr(9995) << endl;
+
+    // 用 writev 输出，不复制字符
+    int fds[2];
+    if (pipe(fds) == 0) {
+        rope msg("HTTP/1.1 200 OK\r\n");
+        msg += "Content-Length: 5\r\n\r\n";
+        msg += "hello";
+        struct iovec iov[16];
+        int n = 0;
+        for (rope::chunk_iterator it = msg.chunk_begin(); it != msg.chunk_end() && n < 16; ++it, ++n) {
+            iov[n].iov_base = (void *) it->data();
+            iov[n].iov_len = it->size();
+        }
+        ssize_t w = writev(fds[1], iov, n);
+        char buf[128];
+        ssize_t rd = read(fds[0], buf, sizeof(buf));
+        cout << "writev: " << w << " " << (rd == w && string_view(buf, rd) == msg.to_string()) << endl;
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    try {
+        r.at(100);
+    }
+    catch (const std::out_of_range &) {
+        cout << "out_of_range" << endl;
+    }
+    return 0;
+}
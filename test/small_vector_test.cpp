@@ -0,0 +1,102 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>          // for malloc, free
+#include "../include/small_vector.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+// 只有 allocate 和 deallocate 的配置器，没有 good_size
+struct bare_alloc {
+    static void * allocate(size_t n) { return malloc(n); }
+    static void deallocate(void *p, size_t) { free(p); }
+};
+
+template <typename V>
+void print(const char * name, const V & v) {
+    cout << name << " (" << v.size() << "/" << v.capacity()
+         << (v.is_inline() ? ", inline" : ", heap") << "):";
+    for (typename V::const_iterator it = v.begin(); it != v.end(); ++it)
+        cout << " " << *it;
+    cout << endl;
+}
+
+int main() {
+    small_vector<int, 4> a;
+    for (int i = 0; i < 4; ++i)
+        a.push_back(i);
+    print("a", a);
+    a.push_back(4);
+    print("a", a);
+    a.erase(a.begin() + 1, a.begin() + 3);
+    a.insert(a.begin(), 2, -1);
+    print("a", a);
+    a.resize(3);
+    a.shrink_to_fit();
+    print("a", a);
+
+    // 元素在内联空间中时逐个移动
+    small_vector<std::string, 2> s;
+    s.push_back("short");
+    s.emplace_back(30, 'x');
+    small_vector<std::string, 2> t(ministl::move(s));
+    print("s", s);
+    print("t", t);
+
+    // 元素在堆上时直接接管
+    t.insert(t.begin() + 1, t[0]);
+    small_vector<std::string, 2> u(ministl::move(t));
+    print("t", t);
+    print("u", u);
+
+    u.swap(s);
+    s.swap(t);
+    print("s", s);
+    print("t", t);
+
+    const int arr[] = {7, 8, 9};
+    small_vector<int, 4> b(arr, arr + 3);
+    b.insert(b.begin() + 1, arr, arr + 3);
+    print("b", b);
+    a = b;
+    print("a = b", a);
+    b = small_vector<int, 4>(2, 5);
+    print("b", b);
+
+    // 空区间的 erase 不改变任何元素
+    small_vector<std::string, 2> e;
+    e.push_back("aaa");
+    e.push_back("bbb");
+    e.push_back("ccc");
+    e.erase(e.begin() + 1, e.begin() + 1);
+    e.erase(e.end(), e.end());
+    print("empty erase", e);
+
+    // 与 vector 一样按 Growth 增长
+    small_vector<int, 2, allocator<int>, half_growth> h;
+    cout << "half growth capacities:";
+    for (int i = 0; i < 20; ++i) {
+        if (h.size() == h.capacity()) cout << " " << h.capacity();
+        h.push_back(i);
+    }
+    cout << endl;
+
+    // 离开内联空间之后，可以平凡重定位的元素由 reallocate 扩容
+    small_vector<int, 4, allocator<int, malloc_alloc> > m(4, 1);
+    m.insert(m.begin() + 2, 3, 2);
+    m.insert(m.begin(), arr, arr + 3);
+    m.reserve(100);
+    m.push_back(3);
+    print("m", m);
+
+    // 配置器没有 good_size 时 shrink_to_fit 只保留 size() 个元素
+    small_vector<int, 4, allocator<int, bare_alloc> > bare(10, 1);
+    bare.push_back(2);
+    bare.shrink_to_fit();
+    print("bare", bare);
+    bare.resize(3);
+    bare.shrink_to_fit();
+    print("bare", bare);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include "../include/string.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+// 逐字节的参考实现
+size_t naive_find(const char *p, size_t n, const char *s, size_t m) {
+    for (size_t i = 0; i + m <= n; ++i)
+        if (0 == memcmp(p + i, s, m)) return i;
+    return string_view::npos;
+}
+
+int main() {
+    srand(1);
+    // 字母表很小，匹配和部分匹配都很多；每个长度都从不同的偏移开始，覆盖各种对齐和块尾
+    const size_t MAXN = 200;
+    char buf[MAXN + 64];
+    size_t checked = 0, errors = 0;
+    for (int round = 0; round < 20000; ++round) {
+        size_t n = rand() % MAXN;
+        size_t off = rand() % 33;
+        for (size_t i = 0; i < n; ++i) buf[off + i] = "abc"[rand() % 3];
+        string_view v(buf + off, n);
+        char needle[8];
+        size_t m = rand() % 7;
+        for (size_t i = 0; i < m; ++i) needle[i] = "abcd"[rand() % 4];
+        string_view s(needle, m);
+        size_t pos = n ? rand() % (n + 1) : 0;
+
+        size_t expect = naive_find(v.data() + pos, n - pos, needle, m);
+        if (expect != string_view::npos) expect += pos;
+        errors += v.find(s, pos) != expect;
+
+        char c = "abcd"[rand() % 4];
+        expect = naive_find(v.data() + pos, n - pos, &c, 1);
+        if (expect != string_view::npos) expect += pos;
+        errors += v.find(c, pos) != expect;
+
+        expect = string_view::npos;
+        for (size_t i = 0; i < n && i <= pos; ++i) if (buf[off + i] == c) expect = i;
+        errors += v.rfind(c, pos) != expect;
+
+        expect = string_view::npos;
+        for (size_t i = n - m + 1; m <= n && i-- > 0; )
+            if (i <= pos && 0 == memcmp(v.data() + i, needle, m)) { expect = i; break; }
+        errors += v.rfind(s, pos) != expect;
+
+        expect = string_view::npos;
+        for (size_t i = pos; i < n && expect == string_view::npos; ++i)
+            if (memchr(needle, buf[off + i], m)) expect = i;
+        errors += v.find_first_of(s, pos) != expect;
+        checked += 5;
+    }
+    cout << "checked " << checked << ", errors " << errors << endl;
+
+    // 大字符集走查表的版本
+    string_view text("the quick brown fox jumps over the lazy dog 0123456789");
+    cout << text.find_first_of("0123456789ABCDEFGHIJ") << " " << text.find_first_of("xyz") << endl;
+
+    string h("Content-Type: text/html\r\nContent-Length: 42\r\n\r\n");
+    cout << h.find("\r\n\r\n") << " " << h.find(':') << " " << h.rfind("Content") << " "
+         << h.find_first_of("\r\n") << " " << h.compare("Content") << " " << h.compare(h) << endl;
+
+    // 长文本中查找，打印吞吐量
+    const size_t N = 64 << 20;
+    string big(N, 'x');
+    for (size_t i = 0; i < N; i += 61) big[i] = 'a' + i % 26;
+    big[N - 3] = '\r';
+    string_view needles[] = { "\r", "\r\n", "Host: ", "\r\n:" };
+    for (int k = 0; k < 4; ++k) {
+        auto start = std::chrono::steady_clock::now();
+        size_t r = k < 3 ? big.find(needles[k]) : big.find_first_of(needles[k]);
+        std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+        cout << (k < 3 ? "find" : "find_first_of") << " " << needles[k].size() << " chars: "
+             << r << " " << N / sec.count() / 1e9 << " GB/s" << endl;
+    }
+    return 0;
+}
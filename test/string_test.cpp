@@ -21,5 +21,67 @@ int main() {
     v.push_back(b);
     cout << "=======" << endl;
     v.push_back(b);
+
+    // 短字符串存放在对象内部
+    cout << "sizeof: " << sizeof(string) << " sso: " << string::SSO_CAPACITY << endl;
+    string s23("abcdefghijklmnopqrstuvw");
+    string s24("abcdefghijklmnopqrstuvwx");
+    cout << s23 << " " << s23.size() << " " << s23.is_inline() << " " << (s23.c_str()[23] == '\0') << endl;
+    cout << s24 << " " << s24.size() << " " << s24.is_inline() << " " << s24.capacity() << endl;
+
+    string c(s23), d(s24);
+    string e(ministl::move(d));
+    cout << c << " " << e << " " << e.is_inline() << " " << d.size() << " " << d.empty() << endl;
+    c = s24;
+    e = a;
+    d = ministl::move(c);
+    cout << c.size() << " " << d << " " << e << " " << e.is_inline() << endl;
+    d[0] = 'X';
+    for (string::const_iterator it = d.begin(); it != d.end(); ++it)
+        cout << *it;
+    cout << endl;
+
+    // 追加时容量按倍数增长
+    string g;
+    size_t reallocs = 0, last_cap = g.capacity();
+    for (int i = 0; i < 100000; ++i) {
+        g.push_back(char('a' + i % 26));
+        if (g.capacity() != last_cap) { ++reallocs; last_cap = g.capacity(); }
+    }
+    cout << "push_back: " << g.size() << " " << (reallocs < 20) << " " << g[99999] << endl;
+
+    string h("hello");
+    h += ", ";
+    h += string("world");
+    h += '!';
+    h.append(3, '.');
+    cout << h << " " << h.size() << " " << h.is_inline() << endl;
+    h.insert(0, "<<");
+    h.insert(h.size(), ">>");
+    h.insert(7, 2, '-');
+    cout << h << endl;
+    h.erase(7, 2);
+    h.erase(h.begin());
+    h.erase(h.end() - 1);
+    h.erase(h.begin(), h.begin() + 1);
+    cout << h << endl;
+    h.append(h);                       // 追加自身，增长时源地址跟着移动
+    cout << h << " " << h.is_inline() << endl;
+    h.insert(6, h.c_str() + 3, 8);     // 插入自身的一段，跨过插入点
+    cout << h << endl;
+    h.erase(12);
+    h.shrink_to_fit();
+    cout << h << " " << h.is_inline() << endl;
+
+    string r;
+    r.reserve(1000);
+    const char * before = r.data();
+    for (int i = 0; i < 100; ++i) r += "0123456789";
+    cout << "reserve: " << r.capacity() << " " << (before == r.data()) << endl;
+    r.resize(5);
+    r.resize(8, 'x');
+    cout << r + "|" + s23 << " " << (string("ab") + string("cd")) << endl;
+    swap(r, s24);
+    cout << r << " " << s24 << endl;
     return 0;
-}
\ No newline at end of file
+}
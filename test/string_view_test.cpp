@@ -0,0 +1,68 @@
+#include <iostream>
+#include "../include/string.h"
+#include "../include/string_view.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+// 参数是 string_view 时 string 和 C 字符串都可以直接传入
+size_t count_char(string_view s, char c) {
+    size_t n = 0;
+    for (size_t pos = s.find(c); pos != string_view::npos; pos = s.find(c, pos + 1))
+        ++n;
+    return n;
+}
+
+int main() {
+    string line("GET /index.html HTTP/1.1\r\nHost: example.com\r\nAccept: */*\r\n");
+    string_view v = line;
+    cout << "view: " << v.size() << " " << (v.data() == line.data()) << endl;
+    cout << "count: " << count_char(line, '\n') << " " << count_char("a,b,,c", ',') << endl;
+
+    // 切分得到的片段都指向 line 的缓冲区
+    vector<string_view> lines = split(v, "\r\n");
+    cout << "lines: " << lines.size() << endl;
+    for (size_t i = 0; i < lines.size(); ++i)
+        cout << "[" << lines[i] << "] " << (lines[i].data() >= line.data()
+                                           && lines[i].end() <= line.data() + line.size()) << endl;
+
+    vector<string_view> fields;
+    split(lines[0], ' ', fields);
+    cout << "fields: " << fields.size() << " " << fields[0] << "|" << fields[1] << "|" << fields[2] << endl;
+    fields.clear();
+    split("a,,b,", ',', fields);
+    cout << "empty fields: " << fields.size() << " [" << fields[1] << "] [" << fields[3] << "]" << endl;
+
+    string_view host = lines[1];
+    size_t colon = host.find(':');
+    cout << "header: " << host.substr(0, colon) << " = " << host.substr(colon + 2) << endl;
+    cout << "find: " << v.find("HTTP") << " " << v.find("HTTQ") << " " << v.find("") << " "
+         << v.find('G', 1) << " " << v.rfind('/') << " " << v.find_first_of(":*") << endl;
+    cout << "starts/ends: " << v.starts_with("GET ") << " " << v.ends_with("\r\n") << " "
+         << host.starts_with("Accept") << endl;
+
+    // 比较运算符对 string 和 string_view 都适用
+    string a("apple"), b("apples");
+    cout << "compare: " << (a < b) << " " << (a == "apple") << " " << (b != a) << " "
+         << string_view("b").compare("a") << " " << string_view("ab").compare("abc") << endl;
+
+    string c(fields[0]);
+    c += string_view(", ");
+    c.append(host.substr(0, 4));
+    cout << "string: " << c << endl;
+
+    try {
+        v.substr(v.size() + 1);
+    }
+    catch (const std::out_of_range &) {
+        cout << "out_of_range" << endl;
+    }
+    try {
+        split(v, "");
+    }
+    catch (const std::invalid_argument &) {
+        cout << "invalid_argument" << endl;
+    }
+    return 0;
+}
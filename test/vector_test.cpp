@@ -0,0 +1,176 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>          // for malloc, free
+#include "../include/vector.h"
+
+using namespace ministl;
+using std::cout;
+using std::endl;
+
+// 统计复制和移动的次数
+struct tracker {
+    static int copies;
+    static int moves;
+    int value;
+
+    tracker(int v = 0) : value(v) { }
+    tracker(const tracker & x) : value(x.value) { ++copies; }
+    tracker(tracker && x) noexcept : value(x.value) { ++moves; x.value = -1; }
+    tracker & operator=(const tracker & x) { value = x.value; ++copies; return *this; }
+    tracker & operator=(tracker && x) noexcept { value = x.value; ++moves; x.value = -1; return *this; }
+};
+
+int tracker::copies = 0;
+int tracker::moves = 0;
+
+// 移动构造可能抛出异常，扩容时只能复制
+struct throwing_move {
+    static int copies;
+    throwing_move() { }
+    throwing_move(const throwing_move &) { ++copies; }
+    throwing_move(throwing_move &&) { }
+    throwing_move & operator=(const throwing_move &) = default;
+};
+
+int throwing_move::copies = 0;
+
+// 只持有一个堆指针，可以平凡重定位
+struct handle {
+    static int moves;
+    int *p;
+    explicit handle(int v) : p(new int(v)) { }
+    handle(handle && x) noexcept : p(x.p) { x.p = nullptr; ++moves; }
+    handle(const handle & x) : p(new int(*x.p)) { }
+    handle & operator=(const handle & x) { int *t = new int(*x.p); delete p; p = t; return *this; }
+    handle & operator=(handle && x) noexcept { int *t = p; p = x.p; x.p = t; ++moves; return *this; }
+    ~handle() { delete p; }
+};
+
+int handle::moves = 0;
+
+namespace ministl {
+template <> struct is_trivially_relocatable<handle> : true_type { };
+}
+
+// 只有 allocate 和 deallocate 的配置器，没有 good_size
+struct bare_alloc {
+    static void * allocate(size_t n) { return malloc(n); }
+    static void deallocate(void *p, size_t) { free(p); }
+};
+
+// 依次输出扩容后的容量
+template <typename Vector>
+void print_capacities(const char * name, int n) {
+    Vector v;
+    cout << name << ":";
+    size_t cap = v.capacity();
+    for (int i = 0; i < n; ++i) {
+        v.push_back(typename Vector::value_type());
+        if (v.capacity() != cap) {
+            cap = v.capacity();
+            cout << " " << cap;
+        }
+    }
+    cout << endl;
+}
+
+int main() {
+    vector<tracker> v;
+    for (int i = 0; i < 1000; ++i)
+        v.emplace_back(i);
+    cout << "emplace_back: copies " << tracker::copies << ", moves " << tracker::moves << endl;
+
+    tracker::copies = tracker::moves = 0;
+    v.insert(v.begin(), tracker(-2));
+    v.erase(v.begin());
+    cout << "insert + erase: copies " << tracker::copies << ", moves " << tracker::moves << endl;
+
+    // 用自己的元素插入，扩容时不能先移走被引用的元素
+    vector<std::string> s;
+    s.push_back(std::string(40, 'a'));
+    for (int i = 0; i < 10; ++i)
+        s.push_back(s[0]);
+    s.emplace(s.begin(), s.back());
+    cout << "self insert: " << s.size() << " " << (s[0] == s[10]) << " " << s[0].size() << endl;
+
+    vector<std::string> t(ministl::move(s));
+    cout << "moved: " << s.size() << " " << t.size() << endl;
+    s = ministl::move(t);
+    cout << "move assigned: " << s.size() << " " << t.size() << endl;
+
+    vector<throwing_move> w;
+    for (int i = 0; i < 100; ++i)
+        w.push_back(throwing_move());
+    cout << "throwing move copies: " << throwing_move::copies << endl;
+
+    // 可以平凡重定位的元素扩容时交给 realloc，大区块常常可以原地扩展
+    vector<double, allocator<double, malloc_alloc> > d;
+    int growths = 0, in_place = 0;
+    for (int i = 0; i < (1 << 20); ++i) {
+        const double *old = d.begin();
+        bool full = d.size() == d.capacity();
+        d.push_back(i);
+        if (full) {
+            ++growths;
+            if (old == d.begin()) ++in_place;
+        }
+    }
+    cout << "double growths: " << growths << ", in place: " << in_place << ", last: " << d[(1 << 20) - 1] << endl;
+
+    vector<handle> h;
+    for (int i = 0; i < 1000; ++i)
+        h.emplace_back(i);
+    h.insert(h.begin() + 10, 3, h[999]);
+    cout << "handle moves: " << handle::moves << ", h[10] " << *h[10].p << ", h[1002] " << *h[1002].p << endl;
+
+    v.reserve(5000);
+    cout << "reserve: " << v.size() << " " << v.capacity() << endl;
+    v.erase(v.begin() + 10, v.end());
+    v.shrink_to_fit();
+    cout << "shrink_to_fit: " << v.size() << " " << v.capacity() << " " << v[9].value << endl;
+
+    // 删除空区间不改变任何元素
+    vector<std::string> e;
+    const char * words[] = { "aaa", "bbb", "ccc", "ddd" };
+    for (int i = 0; i < 4; ++i) e.push_back(words[i]);
+    e.erase(e.begin() + 1, e.begin() + 1);
+    e.erase(e.end(), e.end());
+    cout << "empty erase: " << e.size() << " " << e[0] << " " << e[1] << " " << e[2] << " " << e[3] << endl;
+
+    // 默认初始化，随后整体覆盖
+    const char msg[] = "hello, world";
+    vector<char> buf(5, default_init);
+    memcpy(buf.begin(), msg, 5);
+    buf.resize_uninitialized(12);
+    memcpy(buf.begin() + 5, msg + 5, 7);
+    buf.append(buf.begin(), buf.begin() + 5);
+    buf.append_n(3, buf[0]);
+    cout << "buffer: " << std::string(buf.begin(), buf.end()) << endl;
+
+    // 比较
+    vector<int> x1(1000, 7), x2(1000, 7);
+    x2[999] = -1;
+    vector<unsigned char> b1(300, 'a'), b2(300, 'a');
+    b2[150] = 'b';
+    vector<double> d1(3, 0.0), d2(3, -0.0);
+    vector<std::string> s1(2, "x"), s2(3, "x");
+    cout << "compare: " << (x1 == x2) << (x2 < x1) << (x1 < x2) << (x1 != x2)
+         << " " << (b1 < b2) << (b2 <= b1) << " " << (d1 == d2)
+         << " " << (s1 < s2) << (s1 == s2) << endl;
+
+    print_capacities<vector<char> >("double", 100);
+    print_capacities<vector<char, allocator<char>, half_growth> >("half", 100);
+    print_capacities<vector<char, allocator<char>, size_class_growth<> > >("size_class", 100);
+    print_capacities<vector<char, allocator<char>, size_class_growth<half_growth> > >("size_class<half>", 100);
+    print_capacities<vector<int, allocator<int, malloc_alloc>, page_growth<half_growth> > >("page<half>", 5000);
+
+    // 配置器没有 good_size 时按申请的大小计算容量
+    print_capacities<vector<char, allocator<char, bare_alloc>, size_class_growth<> > >("bare size_class", 100);
+    print_capacities<vector<int, allocator<int, bare_alloc>, page_growth<> > >("bare page", 5000);
+    vector<int, allocator<int, bare_alloc> > bare(10, 1);
+    bare.push_back(2);
+    bare.shrink_to_fit();
+    cout << "bare shrink_to_fit: " << bare.size() << "/" << bare.capacity() << endl;
+    return 0;
+}